@@ -0,0 +1,141 @@
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <map>
+#include <list>
+#include <set>
+#include <clocale>
+#include <gui_schematic_null.hpp>
+#include <gui_progress_console.hpp>
+#include <circuit.hpp>
+#include "synthetic_netlists.hpp"
+
+//Edge iteration over the GraphView arrays against maps of lists.
+//
+//edge_iteration [passes]
+//
+//Every pass visits each component, its terminal connections, the pins of
+//those and the terminals of the components on them: the two hops a walk of
+//the circuit takes, not crossing the circuit terminals. The maps of lists
+//replicate the adjacency CircuitGraph kept before GraphView, connections and
+//components by name, neighbours listed by name and looked up in the maps.
+namespace {
+
+    typedef circuit::CircuitGraph<gui::GuiSchematicInterfaceExtSync, gui::GuiProgressInterfaceExtSync> Graph;
+
+    struct ListComponent {
+        std::list<std::string> terminals;
+    };
+
+    struct ListConnection {
+        std::list<std::string> components;
+    };
+
+    const std::set<std::string> g_terminals = { "vdd", "vss", "gen", "out" };
+
+    struct ListGraph {
+        std::map<std::string, ListComponent> components;
+        std::map<std::string, ListConnection> connections;
+    };
+
+    struct ViewGraph {
+        const circuit::GraphView& view;
+        std::vector<bool> isTerminal;
+    };
+
+    ListGraph makeListGraph(const Graph& circuit) {
+        ListGraph graph;
+        for(const auto& comp : circuit.getComponents()) {
+            auto& listComp = graph.components[std::string(circuit.getName(comp.getName()))];
+            for(const auto connId : comp.getTerminals()) {
+                const std::string connName(circuit.getName(circuit.getConnections()[connId].getName()));
+                listComp.terminals.emplace_back(connName);
+                graph.connections[connName].components.emplace_back(circuit.getName(comp.getName()));
+            }
+        }
+        return graph;
+    }
+
+    std::size_t iterate(const ViewGraph& graph) {
+        const auto& view = graph.view;
+        std::size_t count = 0;
+        for(circuit::ComponentId compId = 0; compId < view.getComponentsCount(); ++compId) {
+            for(const auto connId : view.getTerminals(compId)) {
+                if(graph.isTerminal[connId]) {
+                    continue;
+                }
+                for(const auto& pin : view.getPins(connId)) {
+                    count += view.getTerminals(pin.component).size();
+                }
+            }
+        }
+        return count;
+    }
+
+    std::size_t iterate(const ListGraph& graph) {
+        std::size_t count = 0;
+        for(const auto& comp : graph.components) {
+            for(const auto& connName : comp.second.terminals) {
+                if(g_terminals.count(connName) != 0) {
+                    continue;
+                }
+                for(const auto& compName : graph.connections.at(connName).components) {
+                    count += graph.components.at(compName).terminals.size();
+                }
+            }
+        }
+        return count;
+    }
+
+    template<typename TGraph>
+    double measure(const TGraph& graph, std::size_t passesCount, std::size_t& count) {
+        const auto start = std::chrono::steady_clock::now();
+        for(std::size_t pass = 0; pass < passesCount; ++pass) {
+            count = iterate(graph);
+        }
+        const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count() / passesCount;
+    }
+
+    void run(const std::string& name, const std::vector<std::string>& lines, std::size_t passesCount) {
+        gui::GuiSchematicNull schematic;
+        gui::GuiProgressConsole progress(name);
+        Graph circuit(&schematic, &progress);
+        benchmarks::addLines(circuit, lines);
+        circuit.freeze();
+        const auto listGraph = makeListGraph(circuit);
+        ViewGraph viewGraph{ circuit.getView(), std::vector<bool>(circuit.getConnections().size(), false) };
+        for(circuit::ConnectionId connId = 0; connId < circuit.getConnections().size(); ++connId) {
+            const std::string connName(circuit.getName(circuit.getConnections()[connId].getName()));
+            viewGraph.isTerminal[connId] = g_terminals.count(connName) != 0;
+        }
+
+        std::size_t viewCount = 0;
+        std::size_t listCount = 0;
+        const auto viewTime = measure(viewGraph, passesCount, viewCount);
+        const auto listTime = measure(listGraph, passesCount, listCount);
+        if(viewCount != listCount) {
+            throw std::runtime_error("Edge counts differ for " + name);
+        }
+
+        std::cout << name << " " << lines.size() << " components, " << viewCount << " edges per pass\n"
+                  << "    GraphView:      " << viewTime << " ms, " << viewCount / viewTime / 1e3 << " M edges/s\n"
+                  << "    maps of lists:  " << listTime << " ms, " << listCount / listTime / 1e3 << " M edges/s" << std::endl;
+    }
+}
+
+int main(int argc, char** argv) {
+    try {
+        std::setlocale(LC_NUMERIC, "C");
+        const std::size_t passesCount = (argc > 1) ? std::stoul(argv[1]) : 20;
+        for(const std::size_t count : { 1000, 100000 }) {
+            run("ladder", benchmarks::makeLadder(count), passesCount);
+            run("mesh", benchmarks::makeMesh(count), passesCount);
+        }
+    } catch(const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,163 @@
+#include <iostream>
+#include <fstream>
+#include <random>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <clocale>
+#include <filesystem>
+#include <gui_schematic_null.hpp>
+#include <gui_progress_console.hpp>
+#include <netlist_updater.hpp>
+
+//Latency of incremental netlist updates against the netlist size.
+//
+//edit_latency [edits]
+//
+//Netlists are made of amplifier stages connected only through the circuit
+//terminals (vdd, vss, gen), so an edit affects one stage whatever the size.
+//Each edit changes a value, adds a resistor or removes a passive component of
+//a random stage, then NetlistUpdater applies it: parsing the changed lines,
+//recommendations and placement. Then the unchanged netlist is updated again,
+//which only reads and compares it: the part of the latency growing with the
+//file size. A circuit that is one island of connected components has to walk
+//all of it on every edit, its latency grows with N.
+namespace {
+
+    typedef circuit::CircuitGraph<gui::GuiSchematicInterfaceExtSync, gui::GuiProgressInterfaceExtSync> Graph;
+
+    const std::vector<std::string> g_stage = {
+        "R0_# vpwr_# vdd 10",
+        "C0_# vdd vss 100u",
+        "Rgen_# gen in_# 330",
+        "Q#npn col_# bas_# emi_# BC548B",
+        "R1_# vdd A_# 47k",
+        "R2_# A_# vss 10k",
+        "C1_# A_# vss 100n",
+        "R3_# A_# bas_# 470",
+        "C3_# M_# bas_# 100n",
+        "C4_# in_# M_# 100n",
+        "L22_# M_# vss 17u",
+        "L33_# vdd X_# 17u",
+        "R4_# X_# col_# 10",
+        "R5_# emi_# vss 100",
+        "C5_# emi_# vss 10u"
+    };
+
+    std::string makeLine(const std::string& pattern, std::size_t stage) {
+        std::string line = pattern;
+        const auto id = std::to_string(stage);
+        for(auto pos = line.find('#'); pos != std::string::npos; pos = line.find('#', pos + id.size())) {
+            line.replace(pos, 1, id);
+        }
+        return line;
+    }
+
+    void writeNetlist(const std::string& filename, const std::vector<std::string>& lines) {
+        std::ofstream ofs(filename, std::ios::binary | std::ios::trunc);
+        ofs << "* edit latency benchmark\n";
+        for(const auto& line : lines) {
+            ofs << line << '\n';
+        }
+        ofs << ".end\n";
+    }
+
+    struct Latencies {
+        std::vector<double> values;
+
+        void add(double value) {
+            values.emplace_back(value);
+        }
+
+        std::string print() {
+            std::sort(values.begin(), values.end());
+            double total = 0;
+            for(const auto value : values) {
+                total += value;
+            }
+            if(values.empty()) {
+                return "none";
+            }
+            return "mean " + std::to_string(total / values.size()) + " ms, median " +
+                std::to_string(values[values.size() / 2]) + " ms, max " + std::to_string(values.back()) + " ms";
+        }
+    };
+
+    double measure(circuit::NetlistUpdater<Graph>& updater, Graph& circuit, gui::GuiProgressConsole& progress,
+                   circuit::NetlistUpdater<Graph>::Result& result) {
+        const auto start = std::chrono::steady_clock::now();
+        result = updater.update(circuit, &progress);
+        const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count();
+    }
+
+    void run(std::size_t componentsCount, std::size_t editsCount) {
+        const auto filename = (std::filesystem::temp_directory_path() /
+                               ("edit_latency_" + std::to_string(componentsCount) + ".cir")).string();
+        std::vector<std::string> lines;
+        const auto stagesCount = componentsCount / g_stage.size();
+        for(std::size_t stage = 0; stage < stagesCount; ++stage) {
+            for(const auto& pattern : g_stage) {
+                lines.emplace_back(makeLine(pattern, stage));
+            }
+        }
+        writeNetlist(filename, lines);
+
+        gui::GuiSchematicNull schematic;
+        gui::GuiProgressConsole progress(filename);
+        Graph circuit(&schematic, &progress);
+        circuit::processNetlist(filename, circuit, &progress, "");
+        circuit::NetlistUpdater<Graph> updater(filename);
+        updater.reset(circuit);
+
+        std::mt19937 rng(1);
+        Latencies edits;
+        Latencies compares;
+        std::size_t fullCount = 0;
+        for(std::size_t edit = 0; edit < editsCount; ++edit) {
+            const auto stage = rng() % stagesCount;
+            const auto line = stage * g_stage.size() + 4 + rng() % (g_stage.size() - 4);
+            switch(rng() % 3) {
+                case 0:
+                    lines[line] = lines[line].substr(0, lines[line].rfind(' ')) + " " + std::to_string(rng() % 1000);
+                    break;
+                case 1:
+                    lines[line] += "\nRe" + std::to_string(edit) + makeLine(" A_# M_# 1k", stage);
+                    break;
+                default:
+                    lines[line] = "*" + lines[line];
+                    break;
+            }
+            writeNetlist(filename, lines);
+
+            circuit::NetlistUpdater<Graph>::Result result;
+            const auto elapsed = measure(updater, circuit, progress, result);
+            if(result == circuit::NetlistUpdater<Graph>::Result::Full) {
+                ++fullCount;
+            } else {
+                edits.add(elapsed);
+            }
+            compares.add(measure(updater, circuit, progress, result));
+        }
+        std::filesystem::remove(filename);
+
+        std::cout << componentsCount << " components, " << fullCount << " of " << editsCount << " edits processed in full\n"
+                  << "    edit:      " << edits.print() << "\n"
+                  << "    unchanged: " << compares.print() << std::endl;
+    }
+}
+
+int main(int argc, char** argv) {
+    try {
+        std::setlocale(LC_NUMERIC, "C");
+        const std::size_t editsCount = (argc > 1) ? std::stoul(argv[1]) : 200;
+        for(const std::size_t componentsCount : { 1000, 10000, 100000 }) {
+            run(componentsCount, editsCount);
+        }
+    } catch(const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
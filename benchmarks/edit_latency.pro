@@ -0,0 +1,18 @@
+######################################################################
+# edit_latency.pro
+######################################################################
+
+QT -= core gui
+CONFIG += console
+CONFIG -= app_bundle
+
+QMAKE_PROJECT_NAME = edit_latency
+
+LOGMODE = -D_SILENT
+
+INCLUDEPATH += ..
+INCLUDEPATH += ../file_io ../parser ../circuit ../task ../gui ../logging
+QMAKE_CXXFLAGS += -O2 -Wextra -pedantic -std=c++17 $$LOGMODE
+
+# Input
+SOURCES += edit_latency.cpp
@@ -0,0 +1,141 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <clocale>
+#include <filesystem>
+#include <gui_schematic_null.hpp>
+#include <gui_progress_console.hpp>
+#include <file_reader.hpp>
+#include <parser_ngspice.hpp>
+#include <tokenizer.hpp>
+
+//Netlist reading and parsing throughput on large netlists.
+//
+//parse_throughput [test_data dir] [lines]
+//
+//The component lines of every test_data netlist are repeated, with names and
+//nets renamed per copy, until the netlist has the requested number of lines.
+//Reported are the tokenizer alone over the lines in memory and FileReader with
+//ParserNGSPICE building the circuit, which reads netlists above 8 MB in parallel.
+namespace {
+
+    typedef circuit::CircuitGraph<gui::GuiSchematicInterfaceExtSync, gui::GuiProgressInterfaceExtSync> Graph;
+
+    std::vector<std::string> readComponentLines(const std::string& filename) {
+        std::ifstream ifs(filename);
+        if(!ifs.is_open()) {
+            throw std::runtime_error(std::string("File open error '") + filename + std::string("'"));
+        }
+        std::vector<std::string> lines;
+        std::string line;
+        std::getline(ifs, line);
+        while(std::getline(ifs, line)) {
+            const auto first = line.find_first_not_of(" \t\r");
+            if(first != std::string::npos && line[first] != '.' && line[first] != '*') {
+                lines.emplace_back(line.substr(first));
+            }
+        }
+        return lines;
+    }
+
+    //Every token but the value gets the copy appended
+    std::string renameLine(const std::string& line, std::size_t copy) {
+        std::istringstream iss(line);
+        std::vector<std::string> tokens;
+        std::string token;
+        while(iss >> token) {
+            tokens.emplace_back(token);
+        }
+        std::string renamed;
+        for(std::size_t i = 0; i < tokens.size(); ++i) {
+            renamed += tokens[i];
+            if(i + 1 < tokens.size()) {
+                renamed += "_" + std::to_string(copy) + " ";
+            }
+        }
+        return renamed;
+    }
+
+    double getSeconds(std::chrono::steady_clock::time_point start) {
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count();
+    }
+
+    void run(const std::string& netlist, std::size_t minLinesCount) {
+        const auto source = readComponentLines(netlist);
+        if(source.empty()) {
+            return;
+        }
+
+        std::string text = "* parse throughput benchmark\n";
+        std::size_t linesCount = 0;
+        for(std::size_t copy = 0; linesCount < minLinesCount; ++copy) {
+            for(const auto& line : source) {
+                text += renameLine(line, copy) + "\n";
+            }
+            linesCount += source.size();
+        }
+        const auto filename = (std::filesystem::temp_directory_path() / "parse_throughput.cir").string();
+        {
+            std::ofstream ofs(filename, std::ios::binary | std::ios::trunc);
+            ofs << text;
+        }
+        const double megabytes = text.size() / (1024.0 * 1024.0);
+
+        auto start = std::chrono::steady_clock::now();
+        parsers::Tokenizer tokenizer;
+        std::size_t tokensCount = 0;
+        std::size_t pos = 0;
+        while(pos < text.size()) {
+            const auto end = text.find('\n', pos);
+            tokensCount += tokenizer.tokenize(std::string_view(text).substr(pos, end - pos)).size();
+            pos = end + 1;
+        }
+        const auto tokenizeTime = getSeconds(start);
+
+        gui::GuiSchematicNull schematic;
+        gui::GuiProgressConsole progress(filename);
+        Graph circuit(&schematic, &progress);
+        start = std::chrono::steady_clock::now();
+        {
+            parsers::ParserNGSPICE<Graph> parser(circuit, filename);
+            file_reader::FileReader<parsers::ParserInterface, gui::GuiProgressInterfaceExtSync> reader(&parser, &progress);
+            reader.readFile(filename);
+        }
+        const auto parseTime = getSeconds(start);
+        std::filesystem::remove(filename);
+
+        std::cout << std::filesystem::path(netlist).filename().string() << ": " << linesCount << " lines, "
+                  << megabytes << " MB, " << circuit.getComponents().size() << " components\n"
+                  << "    tokenizer: " << tokenizeTime << " s, " << megabytes / tokenizeTime << " MB/s ("
+                  << tokensCount << " tokens)\n"
+                  << "    parse:     " << parseTime << " s, " << megabytes / parseTime << " MB/s, "
+                  << linesCount / parseTime / 1e6 << " M lines/s" << std::endl;
+    }
+}
+
+int main(int argc, char** argv) {
+    try {
+        std::setlocale(LC_NUMERIC, "C");
+        const std::string dir = (argc > 1) ? argv[1] : "../test_data";
+        const std::size_t linesCount = (argc > 2) ? std::stoul(argv[2]) : 2000000;
+        std::vector<std::string> netlists;
+        for(const auto& entry : std::filesystem::directory_iterator(dir)) {
+            if(entry.is_regular_file()) {
+                netlists.emplace_back(entry.path().string());
+            }
+        }
+        std::sort(netlists.begin(), netlists.end());
+        for(const auto& netlist : netlists) {
+            run(netlist, linesCount);
+        }
+    } catch(const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,52 @@
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <clocale>
+#include <gui_schematic_null.hpp>
+#include <gui_progress_console.hpp>
+#include <placement.hpp>
+#include "synthetic_netlists.hpp"
+
+//Time of Placement::run() against the circuit size.
+//
+//placement [max components]
+//
+//Recommendations are created first and not timed. Every component of a
+//ladder has a recommendation, most of a mesh have none.
+namespace {
+
+    typedef circuit::CircuitGraph<gui::GuiSchematicInterfaceExtSync, gui::GuiProgressInterfaceExtSync> Graph;
+
+    void run(const std::string& name, const std::vector<std::string>& lines) {
+        gui::GuiSchematicNull schematic;
+        gui::GuiProgressConsole progress(name);
+        Graph circuit(&schematic, &progress);
+        benchmarks::addLines(circuit, lines);
+        circuit.freeze();
+        circuit.setTerminals( { "vdd", "vss", "gen", "out" } );
+        circuit.createRecomendations();
+
+        const auto start = std::chrono::steady_clock::now();
+        circuit::Placement<Graph>(circuit).run();
+        const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+        std::cout << name << " " << lines.size() << " components: " << elapsed.count() << " ms, "
+                  << elapsed.count() * 1e3 / lines.size() << " us per component" << std::endl;
+    }
+}
+
+int main(int argc, char** argv) {
+    try {
+        std::setlocale(LC_NUMERIC, "C");
+        const std::size_t maxCount = (argc > 1) ? std::stoul(argv[1]) : 100000;
+        for(std::size_t count = 1000; count <= maxCount; count *= 10) {
+            run("ladder", benchmarks::makeLadder(count));
+            run("mesh", benchmarks::makeMesh(count));
+        }
+    } catch(const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,58 @@
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <clocale>
+#include <gui_schematic_null.hpp>
+#include <gui_progress_console.hpp>
+#include <circuit.hpp>
+#include "synthetic_netlists.hpp"
+
+//Time of CircuitGraph::createRecomendations() against the circuit size.
+//
+//recommendations [max components]
+//
+//A ladder is one long path from the core, a mesh has a number of paths
+//between two nodes growing exponentially with its size. Both are a single
+//island, so every component is walked.
+namespace {
+
+    typedef circuit::CircuitGraph<gui::GuiSchematicInterfaceExtSync, gui::GuiProgressInterfaceExtSync> Graph;
+
+    void run(const std::string& name, const std::vector<std::string>& lines) {
+        gui::GuiSchematicNull schematic;
+        gui::GuiProgressConsole progress(name);
+        Graph circuit(&schematic, &progress);
+        benchmarks::addLines(circuit, lines);
+        circuit.freeze();
+        circuit.setTerminals( { "vdd", "vss", "gen", "out" } );
+
+        const auto start = std::chrono::steady_clock::now();
+        circuit.createRecomendations();
+        const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+        std::size_t recommendedCount = 0;
+        for(const auto& comp : circuit.getComponents()) {
+            if(comp.getRecommendation().getDirection() != circuit::Recommendation::Direction::None) {
+                ++recommendedCount;
+            }
+        }
+        std::cout << name << " " << lines.size() << " components: " << elapsed.count() << " ms, "
+                  << recommendedCount << " recommended" << std::endl;
+    }
+}
+
+int main(int argc, char** argv) {
+    try {
+        std::setlocale(LC_NUMERIC, "C");
+        const std::size_t maxCount = (argc > 1) ? std::stoul(argv[1]) : 100000;
+        for(std::size_t count = 100; count <= maxCount; count *= 10) {
+            run("ladder", benchmarks::makeLadder(count));
+            run("mesh", benchmarks::makeMesh(count));
+        }
+    } catch(const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,70 @@
+#ifndef SYNTHETIC_NETLISTS
+#define SYNTHETIC_NETLISTS
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+//Generated netlists of a given size for the benchmarks, one component per line.
+//Both have a transistor core between gen and vss and end at vdd, every
+//component is connected to the core.
+namespace benchmarks {
+
+    //Series resistors from the core collector to vdd, a capacitor to vss at every node
+    inline std::vector<std::string> makeLadder(std::size_t componentsCount) {
+        std::vector<std::string> lines = { "Qcore n0 gen vss BC548B" };
+        const auto stagesCount = std::max<std::size_t>(componentsCount / 2, 1);
+        for(std::size_t i = 0; i < stagesCount; ++i) {
+            const auto node = "n" + std::to_string(i);
+            const auto next = "n" + std::to_string(i + 1);
+            lines.emplace_back("R" + std::to_string(i) + " " + node + " " + next + " 1k");
+            lines.emplace_back("C" + std::to_string(i) + " " + next + " vss 1n");
+        }
+        lines.emplace_back("Rend n" + std::to_string(stagesCount) + " vdd 1k");
+        return lines;
+    }
+
+    //Square grid of resistors, the core collector at one corner and vdd at the opposite one
+    inline std::vector<std::string> makeMesh(std::size_t componentsCount) {
+        const auto side = std::max<std::size_t>(static_cast<std::size_t>(std::sqrt(componentsCount / 2.0)), 2);
+        auto node = [](std::size_t x, std::size_t y) {
+            return "g" + std::to_string(x) + "_" + std::to_string(y);
+        };
+        std::vector<std::string> lines = { "Qcore " + node(0, 0) + " gen vss BC548B" };
+        for(std::size_t y = 0; y < side; ++y) {
+            for(std::size_t x = 0; x < side; ++x) {
+                const auto id = std::to_string(x) + "_" + std::to_string(y);
+                if(x + 1 < side) {
+                    lines.emplace_back("Rh" + id + " " + node(x, y) + " " + node(x + 1, y) + " 1k");
+                }
+                if(y + 1 < side) {
+                    lines.emplace_back("Rv" + id + " " + node(x, y) + " " + node(x, y + 1) + " 1k");
+                }
+            }
+        }
+        lines.emplace_back("Rend " + node(side - 1, side - 1) + " vdd 1k");
+        return lines;
+    }
+
+    //Adds the lines the way the parser does: type, name, connections, value
+    template<typename TCircuitGraph>
+    void addLines(TCircuitGraph& circuit, const std::vector<std::string>& lines) {
+        std::vector<std::string_view> tokens;
+        std::vector<std::string_view> connections;
+        for(const auto& line : lines) {
+            tokens.clear();
+            std::size_t pos = 0;
+            while(pos < line.size()) {
+                const auto end = std::min(line.find(' ', pos), line.size());
+                tokens.emplace_back(std::string_view(line).substr(pos, end - pos));
+                pos = end + 1;
+            }
+            connections.assign(tokens.begin() + 1, tokens.end() - 1);
+            circuit.addComponent(tokens[0].substr(0, 1), tokens[0], tokens.back(), connections);
+        }
+    }
+}
+
+#endif
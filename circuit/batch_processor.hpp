@@ -0,0 +1,92 @@
+#ifndef BATCH_PROCESSOR
+#define BATCH_PROCESSOR
+
+#include <string>
+#include <vector>
+#include <set>
+#include <atomic>
+#include <future>
+#include <filesystem>
+#include <pipeline.hpp>
+#include <circuit_export.hpp>
+#include <gui_schematic_null.hpp>
+#include <gui_progress_console.hpp>
+#include <thread_pool.hpp>
+#include <logger.hpp>
+
+namespace circuit {
+
+    //Headless processing of many netlists, one pool task per netlist.
+    //Every netlist gets an export file in the output directory.
+    class BatchProcessor {
+
+        typedef circuit::CircuitGraph<gui::GuiSchematicInterfaceExtSync,
+                                      gui::GuiProgressInterfaceExtSync> TCircuitGraph;
+
+        std::string m_outDir;
+
+        //Netlists sharing a file name get their position in the batch appended,
+        //counted up while it still collides, e.g. with a netlist named that way
+        std::vector<std::string> getOutputNames(const std::vector<std::string>& filenames) const {
+            std::vector<std::string> names;
+            std::set<std::string> used;
+            for(std::size_t i = 0; i < filenames.size(); ++i) {
+                const auto stem = std::filesystem::path(filenames[i]).filename().string();
+                auto name = stem;
+                for(auto suffix = i; !used.emplace(name).second; ++suffix) {
+                    name = stem + "_" + std::to_string(suffix);
+                }
+                names.emplace_back((std::filesystem::path(m_outDir) / (name + ".layout")).string());
+            }
+            return names;
+        }
+
+        void processOne(const std::string& filename, const std::string& outName) const {
+            gui::GuiSchematicNull schematic;
+            gui::GuiProgressConsole progress(filename);
+            TCircuitGraph circuit(&schematic, &progress);
+
+            processNetlist(filename, circuit, &progress);
+            exportCircuit(circuit, filename, outName);
+        }
+
+        public:
+        BatchProcessor(const std::string& outDir)
+            : m_outDir(outDir) {
+        }
+
+        virtual ~BatchProcessor() = default;
+
+        //Returns the number of netlists which failed
+        std::size_t run(const std::vector<std::string>& filenames) {
+            std::filesystem::create_directories(m_outDir);
+            const auto outNames = getOutputNames(filenames);
+
+            std::atomic<std::size_t> failed(0);
+            {
+                task::ThreadPool pool;
+                std::vector<std::future<void>> results;
+                for(std::size_t i = 0; i < filenames.size(); ++i) {
+                    results.emplace_back(pool.submit([&, i]() {
+                            try {
+                                processOne(filenames[i], outNames[i]);
+                            } catch(const std::exception& e) {
+                                ++failed;
+                                logging::error("\033[0;31m[", filenames[i], "] Exception raised:\n", e.what(), "\033[0m");
+                            }
+                            }));
+                }
+
+                for(auto& res : results) {
+                    res.get();
+                }
+            }
+
+            logging::info("Batch finished, ", filenames.size() - failed, " of ", filenames.size(), " netlists processed");
+            logging::flush();
+            return failed;
+        }
+    };
+}
+
+#endif
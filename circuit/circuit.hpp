@@ -2,30 +2,53 @@
 #define CIRCUIT
 
 #include <string>
-#include <list>
-#include <set>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <unordered_set>
+#include <unordered_map>
+#include <memory_resource>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <cctype>
 #include <initializer_list>
+#include <symbol_table.hpp>
+#include <graph_view.hpp>
+#include <subcircuit.hpp>
+#include <scratch_array.hpp>
+#include <logger.hpp>
 
 namespace circuit {
 
     class Recommendation {
-        static const std::list<Recommendation> priority;
+        public:
+        //Declared in ascending priority
+        enum class Direction : std::uint8_t {
+            None,
+            Down,
+            Right,
+            Left,
+            Up
+        };
 
-        std::string m_name;
-        std::string m_referenceTerminal;
+        private:
+        Direction m_direction;
+        std::uint32_t m_referenceTerminal;
 
         public:
         Recommendation()
-            : m_name(""), m_referenceTerminal("") {}
+            : m_direction(Direction::None), m_referenceTerminal(g_invalidId) {}
 
-        Recommendation(const std::string& name)
-            : m_name(name), m_referenceTerminal("") {
+        Recommendation(Direction direction)
+            : m_direction(direction), m_referenceTerminal(g_invalidId) {
         }
 
         virtual ~Recommendation() = default;
 
         bool operator==(const Recommendation& other) const {
-            return m_name == other.getName();
+            return m_direction == other.getDirection();
         }
 
         bool operator!=(const Recommendation& other) const {
@@ -33,129 +56,119 @@ namespace circuit {
         }
 
         bool operator<(const Recommendation& other) const {
-            if(*this == other) {
-                return false;
-            }
-
-            for(const auto& r : Recommendation::priority) {
-                if(r.getName() == m_name) {
-                    return false;
-                }
-                if(r.getName() == other.getName()) {
-                    return true;
-                }
-            }
-            return false;
+            return m_direction < other.getDirection();
         }
 
         bool operator>(const Recommendation& other) const {
-            return !(*this == other) && !(*this < other);
+            return m_direction > other.getDirection();
+        }
+
+        Direction getDirection() const {
+            return m_direction;
         }
 
         const std::string& getName() const {
-            return m_name;
+            static const std::string names[] = { "", "DOWN", "RIGHT", "LEFT", "UP" };
+            return names[static_cast<std::size_t>(m_direction)];
         }
 
-        void setReferenceTerminal(const std::string& termName) {
-            m_referenceTerminal = termName;
+        //Index into Component::getTerminals()
+        void setReferenceTerminal(std::uint32_t termIdx) {
+            m_referenceTerminal = termIdx;
         }
 
-        const std::string& getReferenceTerminal() const {
+        std::uint32_t getReferenceTerminalIndex() const {
             return m_referenceTerminal;
         }
+
+        std::string getReferenceTerminal() const {
+            return (m_referenceTerminal == g_invalidId) ? std::string() : std::to_string(m_referenceTerminal + 1);
+        }
     };
-    const std::list<Recommendation> Recommendation::priority = {
-                                                                    Recommendation("UP"),
-                                                                    Recommendation("LEFT"),
-                                                                    Recommendation("RIGHT"),
-                                                                    Recommendation("DOWN")
-                                                                };
 
 
+    //Point of the schematic grid, in grid units
+    struct GridPosition {
+        std::int32_t x;
+        std::int32_t y;
+    };
+
+
+    //Components attached to a connection are only known to the GraphView
     class Connection {
-        std::string m_name;
-        std::list<std::string> m_components;
+        SymbolId m_name;
+
+        Connection(const Connection&) = delete;
+        Connection& operator=(const Connection&) = delete;
 
         public:
-        Connection(const std::string& name)
+        Connection(SymbolId name)
             : m_name(name) {}
 
-        virtual ~Connection() = default;
+        Connection(Connection&&) noexcept = default;
+        Connection& operator=(Connection&&) noexcept = default;
 
-        void attachComponent(const std::string& name) {
-            m_components.emplace_back(name);
-        }
+        virtual ~Connection() = default;
 
-        const std::string& getName() const {
+        SymbolId getName() const {
             return m_name;
         }
-
-        const std::list<std::string>& getComponents() const {
-            return m_components;
-        }
     };
 
 
     class Component {
-        class Terminal {
-            std::string m_name;
-            std::string m_connection;
-
-            public:
-            Terminal(const std::string& name, const std::string& connection)
-                : m_name(name), m_connection(connection) {}
+        SymbolId m_type;
+        SymbolId m_name;
+        SymbolId m_value;
+        std::uint32_t m_terminalsCount;
+        Recommendation m_recommendation;
 
-            const std::string& getName() const {
-                return m_name;
-            }
+        //Where the reference terminal is attached, set by the placement
+        GridPosition m_position;
 
-            const std::string& getConnection() const {
-                return m_connection;
-            }
-        };
+        //Terminal 'i' (named i + 1, as in NGSPICE) is attached to connection m_terminals[i].
+        //Owned by the arena of the CircuitGraph holding the component.
+        const ConnectionId* m_terminals;
 
-        std::string m_type;
-        std::string m_name;
-        std::string m_value;
-        Recommendation m_recommendation;
-        std::list<Terminal> m_terminals;
+        Component(const Component&) = delete;
+        Component& operator=(const Component&) = delete;
 
         public:
-        Component(const std::string& type,
-                const std::string& name,
-                const std::string& value,
-                const std::list<std::string>& connections)
-            : m_type(type), m_name(name), m_value(value), m_recommendation(Recommendation()) {
-
-            std::size_t i = 0;
-            for(auto connName : connections) {
-                Terminal terminal(std::to_string(++i), connName);
-                m_terminals.emplace_back(terminal);
-            }
+        Component(SymbolId type,
+                SymbolId name,
+                SymbolId value,
+                Range<ConnectionId> terminals)
+            : m_type(type),
+            m_name(name),
+            m_value(value),
+            m_terminalsCount(static_cast<std::uint32_t>(terminals.size())),
+            m_position{ 0, 0 },
+            m_terminals(terminals.begin()) {
         }
 
+        Component(Component&&) noexcept = default;
+        Component& operator=(Component&&) noexcept = default;
+
         virtual ~Component() = default;
 
-        const std::string& getType() const {
+        SymbolId getType() const {
             return m_type;
         }
 
-        const std::string& getName() const {
+        SymbolId getName() const {
             return m_name;
         }
 
-        const std::string& getValue() const {
+        SymbolId getValue() const {
             return m_value;
         }
 
-        void getConnections(std::list<std::string>& connections) const {
-            for(const auto& term : m_terminals) {
-                connections.emplace_back(term.getConnection());
-            }
+        Range<ConnectionId> getTerminals() const {
+            return Range<ConnectionId>(m_terminals, m_terminals + m_terminalsCount);
         }
 
-        const std::list<Terminal>& getTerminals() const {
-            return m_terminals;
+        static std::string getTerminalName(std::size_t termIdx) {
+            return std::to_string(termIdx + 1);
         }
 
         const Recommendation& getRecommendation() const {
@@ -165,139 +178,538 @@ namespace circuit {
         void setRecommendation(const Recommendation& recomm) {
             m_recommendation = recomm;
         }
+
+        const GridPosition& getPosition() const {
+            return m_position;
+        }
+
+        void setPosition(const GridPosition& position) {
+            m_position = position;
+        }
     };
 
 
     template<typename TSchematicInterface, typename TProgressInterface>
     class CircuitGraph {
 
-        typedef std::set<Recommendation, std::greater<Recommendation>> RecommPrioritySet;
-
         CircuitGraph(const CircuitGraph&) = delete;
         CircuitGraph& operator=(const CircuitGraph&) = delete;
 
-        std::map<std::string, Recommendation> m_circuitTerminals;
+        static constexpr std::size_t m_progressStep = 4096;
+        static constexpr std::size_t m_patchRatio = 16;
+        static constexpr std::size_t m_arenaBlock = 256 * 1024;
+
+        std::vector<std::pair<SymbolId, Recommendation>> m_circuitTerminals;
 
-        std::map<std::string, Component> m_componentMap;
-        std::map<std::string, Connection> m_connectionMap;
+        //Backs terminal arrays of all components, released in one go
+        std::pmr::monotonic_buffer_resource m_arena;
+
+        SymbolTable m_symbols;
+        std::vector<Component> m_components;
+        std::vector<Connection> m_connections;
+
+        //Indexed by SymbolId, g_invalidId where the symbol names no such object
+        std::vector<ComponentId> m_symbolToComponent;
+        std::vector<ConnectionId> m_symbolToConnection;
+
+        std::vector<std::string> m_dependencies;
+
+        //Names defined by more than one netlist line
+        std::unordered_set<SymbolId> m_duplicates;
+
+        //Shared with the circuits expanded from subcircuit instances, one per expanded definition
+        std::shared_ptr<SubcircuitTable> m_subcircuits;
+        std::unordered_map<const SubcircuitDefinition*, std::unique_ptr<CircuitGraph>> m_expansions;
+
+        //Modified by updateComponent() and removeComponent() since recommendations were last created
+        std::vector<SymbolId> m_touchedComponents;
+        std::vector<ConnectionId> m_touchedConnections;
+
+        //Name of the component recommendations were last walked from, known once
+        //they were created here, not when they were restored from the cache
+        SymbolId m_coreComponent;
+        bool m_coreKnown;
+
+        enum class WalkState : std::uint8_t {
+            New,
+            Walked,
+            Blocked,
+            Done
+        };
+        struct WalkEntry {
+            WalkState state;
+            std::uint32_t depth;
+            Recommendation result;
+        };
+
+        //Traversal state kept between recommendation updates, so that an update
+        //costs as much as the components it visits
+        ScratchArray<WalkEntry> m_componentWalks;
+        ScratchArray<WalkEntry> m_connectionWalks;
+        ScratchArray<Recommendation::Direction> m_connDirections;
+        ScratchArray<bool> m_visited;
+        ScratchArray<bool> m_inIsland;
+        ScratchArray<bool> m_seen;
+
+        GraphView m_view;
+        bool m_frozen;
+        bool m_rebuildView;
 
         TSchematicInterface* m_schIfc;
         TProgressInterface* m_progressIfc;
 
-        void addConnection(const std::string& name) {
-            m_connectionMap.emplace(name, Connection(name));
+        SymbolId intern(std::string_view name) {
+            const auto id = m_symbols.intern(name);
+            if(id >= m_symbolToComponent.size()) {
+                m_symbolToComponent.resize(id + 1, g_invalidId);
+                m_symbolToConnection.resize(id + 1, g_invalidId);
+            }
+            return id;
         }
 
-        Connection& updateConnection(const std::string& name) {
-            auto connIter = m_connectionMap.find(name);
-
-            if(connIter == m_connectionMap.end()) {
-                addConnection(name);
-                connIter = m_connectionMap.find(name);
-                if(connIter == m_connectionMap.end()) {
-                    throw std::runtime_error(std::string("Failed to update connection '") +
-                            name + std::string("'!"));
-                }
+        ConnectionId updateConnection(SymbolId name) {
+            auto& connId = m_symbolToConnection[name];
+            if(connId == g_invalidId) {
+                connId = static_cast<ConnectionId>(m_connections.size());
+                m_connections.emplace_back(name);
             }
-            return connIter->second;
+            return connId;
         }
 
         template<typename T>
-        const T& getObject(const std::map<std::string, T>& table, const std::string& name) const {
-            auto iter = table.find(name);
-            if(iter == table.end()) {
+        const T& getObject(const std::vector<T>& table,
+                           const std::vector<std::uint32_t>& index,
+                           const std::string& name) const {
+            const auto sym = m_symbols.find(name);
+            if(sym == g_invalidId || index[sym] == g_invalidId) {
                 throw std::runtime_error(std::string("Object of type '") + typeid(T).name() + std::string("' and name '") +
                         name + std::string("' not found!"));
             }
-            return iter->second;
+            return table[index[sym]];
         }
 
-        const Component& getCoreComponent() const {
+        //First Q or X component in name order, g_invalidId if there is none,
+        //e.g. in a subcircuit of passive components
+        ComponentId findCoreComponentId() const {
             //Temporary implementation
-            for(const auto& compPair : m_componentMap) {
-                const auto& compType = compPair.second.getType();
-                if(compType == "Q" || compType == "X") {
-                    return compPair.second;
+            const auto typeQ = m_symbols.find("Q");
+            const auto typeX = m_symbols.find("X");
+            ComponentId coreId = g_invalidId;
+            for(ComponentId compId = 0; compId < m_components.size(); ++compId) {
+                const auto& comp = m_components[compId];
+                const auto compType = comp.getType();
+                if((compType == typeQ || compType == typeX) &&
+                        (coreId == g_invalidId || getName(comp.getName()) < getName(m_components[coreId].getName()))) {
+                    coreId = compId;
                 }
             }
-
-            throw std::runtime_error("Core component not found!");
+            return coreId;
         }
 
-        Recommendation getPriorityRecommendation(const RecommPrioritySet& recommendations) const {
-            if(!recommendations.empty()) {
-                auto it = recommendations.begin();
-                std::cout << it->getName() << std::endl;
-                return *it;
-            } else {
-                return Recommendation();
-            }
+        //nullptr if there is none
+        const Component* findCoreComponent() const {
+            const auto coreId = findCoreComponentId();
+            return (coreId == g_invalidId) ? nullptr : &m_components[coreId];
         }
 
-        Recommendation getConnectionRecommendation(const std::string& connName) const {
-            auto it = m_circuitTerminals.find(connName);
-            if(it == m_circuitTerminals.end()) {
-                throw std::runtime_error("");
+        //Depth first walk from the core component, with the rules of the original
+        //path enumeration: a component takes the recommendation found behind its
+        //last terminal not on the path, tagged with that terminal; a connection
+        //takes the highest priority one among the components behind it; terminal
+        //connections end the path with their own recommendation.
+        //
+        //The enumeration walked terminals and components in ascending order and
+        //kept what the last path to a component found, unless it found nothing.
+        //Walking them in descending order reaches every component first along
+        //that last path, later paths reuse its result. A component or connection
+        //finding nothing because the path blocked it is walked once more by the
+        //next path reaching it. So each is walked at most twice, at the cost of
+        //its own pins, the total is O(V + E) and the walk is iterative, so ladders
+        //of any depth fit the stack.
+        //Marks every component reached in m_visited.
+        void walkFromCore(ComponentId coreId,
+                          const std::vector<std::pair<ConnectionId, Recommendation>>& terminals,
+                          std::size_t& visitedCount) {
+            typedef Recommendation::Direction D;
+            static constexpr std::uint32_t unblocked = std::numeric_limits<std::uint32_t>::max();
+
+            const auto& view = getView();
+            m_componentWalks.clear(m_components.size());
+            m_connectionWalks.clear(m_connections.size());
+
+            //'next' counts down, components resolve on their last terminal not on the path.
+            //'blocked' is the lowest depth of the path objects the walk had to skip.
+            struct Frame {
+                bool component;
+                bool again;
+                bool resolved;
+                std::uint32_t id;
+                std::uint32_t next;
+                std::uint32_t blocked;
+                Recommendation result;
+            };
+            std::vector<Frame> stack;
+
+            auto getTerminalDirection = [&](ConnectionId connId) {
+                for(const auto& term : terminals) {
+                    if(term.first == connId) {
+                        return term.second.getDirection();
+                    }
+                }
+                return D::None;
+            };
+
+            auto pushComponent = [&](ComponentId compId) {
+                auto& walk = m_componentWalks[compId];
+                const bool again = walk.state == WalkState::Blocked;
+                walk.state = WalkState::Walked;
+                walk.depth = static_cast<std::uint32_t>(stack.size());
+                if(!m_visited.get(compId)) {
+                    m_visited[compId] = true;
+                    if((++visitedCount % m_progressStep) == 0) {
+                        m_progressIfc->updateProgress(static_cast<std::int32_t>(visitedCount));
+                    }
+                }
+                const auto terminalsCount = static_cast<std::uint32_t>(view.getTerminals(compId).size());
+                stack.push_back(Frame{ true, again, false, compId, terminalsCount, unblocked, Recommendation() });
+            };
+
+            auto pushConnection = [&](ConnectionId connId) {
+                auto& walk = m_connectionWalks[connId];
+                const bool again = walk.state == WalkState::Blocked;
+                walk.state = WalkState::Walked;
+                walk.depth = static_cast<std::uint32_t>(stack.size());
+                const auto pinsCount = static_cast<std::uint32_t>(view.getPins(connId).size());
+                stack.push_back(Frame{ false, again, false, connId, pinsCount, unblocked, Recommendation() });
+            };
+
+            //Result of the terminal of component 'frame' just stepped over
+            auto resolve = [](Frame& frame, D direction) {
+                if(!frame.resolved) {
+                    frame.resolved = true;
+                    frame.result = Recommendation(direction);
+                    frame.result.setReferenceTerminal(frame.next);
+                }
+            };
+
+            //Finished walks found nothing for good, unless the path blocked them
+            auto finish = [&](const Frame& frame, WalkEntry& walk) {
+                const auto depth = static_cast<std::uint32_t>(stack.size() - 1);
+                const bool retry = !frame.again && frame.result == Recommendation() && frame.blocked < depth;
+                walk.state = retry ? WalkState::Blocked : WalkState::Done;
+                walk.result = frame.result;
+                const auto blocked = frame.blocked;
+                stack.pop_back();
+                if(!stack.empty()) {
+                    stack.back().blocked = std::min(stack.back().blocked, blocked);
+                }
+            };
+
+            pushComponent(coreId);
+            while(!stack.empty()) {
+                auto& frame = stack.back();
+                if(frame.component) {
+                    if(frame.next > 0) {
+                        const auto connId = view.getTerminals(frame.id)[--frame.next];
+                        const auto terminalDirection = getTerminalDirection(connId);
+                        const auto& walk = m_connectionWalks[connId];
+                        if(terminalDirection != D::None) {
+                            resolve(frame, terminalDirection);
+                        } else if(walk.state == WalkState::Done) {
+                            resolve(frame, walk.result.getDirection());
+                        } else if(walk.state == WalkState::Walked) {
+                            frame.blocked = std::min(frame.blocked, walk.depth);
+                        } else {
+                            pushConnection(connId);
+                        }
+                        continue;
+                    }
+
+                    const auto compId = frame.id;
+                    const auto result = frame.result;
+                    if(result != Recommendation()) {
+                        m_components[compId].setRecommendation(result);
+                        logging::debug(getName(m_components[compId].getName()), " <- ", result.getName());
+                    }
+                    finish(frame, m_componentWalks[compId]);
+                    if(!stack.empty()) {
+                        auto& parent = stack.back();
+                        parent.result = std::max(parent.result, result);
+                    }
+                } else {
+                    if(frame.next > 0) {
+                        const auto compId = view.getPins(frame.id)[--frame.next].component;
+                        const auto& walk = m_componentWalks[compId];
+                        if(walk.state == WalkState::Done) {
+                            frame.result = std::max(frame.result, walk.result);
+                        } else if(walk.state == WalkState::Walked) {
+                            frame.blocked = std::min(frame.blocked, walk.depth);
+                        } else {
+                            pushComponent(compId);
+                        }
+                        continue;
+                    }
+
+                    const auto direction = frame.result.getDirection();
+                    finish(frame, m_connectionWalks[frame.id]);
+                    resolve(stack.back(), direction);
+                }
             }
-            return it->second;
         }
 
-        Recommendation connectionTraversal(const std::string& connName,
-                                            const std::set<std::string>& compPath,
-                                            const std::set<std::string>& connPath) {
-            try {
-                return getConnectionRecommendation(connName);
-            } catch(const std::runtime_error& e) {
-                //No terminal recommendation found, continue...
+        //Recommendations of the components reached from the core component are
+        //set by walkFromCore(). The rest, which the walk never reaches because
+        //it does not cross circuit terminals, is covered by a multi-source BFS
+        //seeded with the circuit terminals. Sources are queued in priority order,
+        //so every BFS layer stays sorted by priority and each component gets the
+        //highest priority recommendation among its nearest terminals. The reference
+        //terminal is the one facing that terminal. Cost is O(V + E), progress is
+        //reported in visited components.
+        //
+        //With 'island' given, only those components are visited. They have to be
+        //all components reachable from each other without crossing terminals.
+        //Results match the full traversal, at a cost depending on the island only.
+        void propagateRecommendations(const std::vector<ComponentId>* const island = nullptr) {
+            typedef Recommendation::Direction D;
+
+            const auto& view = getView();
+            auto terminals = getTerminalConnections();
+            std::stable_sort(terminals.begin(), terminals.end(), [](const auto& a, const auto& b) {
+                    return a.second > b.second;
+                    });
+
+            m_visited.clear(m_components.size());
+            if(island != nullptr) {
+                m_inIsland.clear(m_components.size());
+                for(const auto compId : *island) {
+                    m_inIsland[compId] = true;
+                }
+            }
+            auto isPending = [&](ComponentId compId) {
+                return (island == nullptr || m_inIsland.get(compId)) && !m_visited.get(compId);
+            };
+
+            std::size_t visitedCount = 0;
+            const auto coreId = (m_coreComponent == g_invalidId) ? g_invalidId : m_symbolToComponent[m_coreComponent];
+            if(coreId != g_invalidId && isPending(coreId)) {
+                walkFromCore(coreId, terminals, visitedCount);
             }
 
-            auto& connObj = getConnectionObject(connName);
-            auto& components = connObj.getComponents();
+            //Direction::None marks connections not visited yet
+            m_connDirections.clear(m_connections.size());
+            std::deque<ConnectionId> queue;
 
-            std::set<std::string> connPathNext = connPath;
-            connPathNext.emplace(connName);
+            auto visit = [&](ComponentId compId, D direction, std::uint32_t terminal) {
+                m_visited[compId] = true;
+                if((++visitedCount % m_progressStep) == 0) {
+                    m_progressIfc->updateProgress(static_cast<std::int32_t>(visitedCount));
+                }
+
+                auto& compObj = m_components[compId];
+                Recommendation recomm(direction);
+                recomm.setReferenceTerminal(terminal);
+                compObj.setRecommendation(recomm);
+                logging::debug(getName(compObj.getName()), " <- ", recomm.getName());
+
+                for(const auto termConn : view.getTerminals(compId)) {
+                    auto& connDirection = m_connDirections[termConn];
+                    if(connDirection == D::None) {
+                        connDirection = direction;
+                        queue.emplace_back(termConn);
+                    }
+                }
+            };
 
-            RecommPrioritySet recommendations;
-            for(const auto& compName : components) {
-                if(compPath.find(compName) == compPath.end()) {
-                    auto recomm = componentTraversal(compName, compPath, connPathNext);
-                    recommendations.emplace(recomm);
+            for(const auto& term : terminals) {
+                auto& connDirection = m_connDirections[term.first];
+                if(connDirection == D::None) {
+                    connDirection = term.second.getDirection();
+                    if(island == nullptr) {
+                        queue.emplace_back(term.first);
+                    }
                 }
             }
 
-            return getPriorityRecommendation(recommendations);
+            if(island != nullptr) {
+                //Island components facing a terminal, visited in the order the full
+                //traversal would: by terminal priority, then by component id
+                struct Seed {
+                    D direction;
+                    ComponentId component;
+                    std::uint32_t terminal;
+                };
+                std::vector<Seed> seeds;
+                for(const auto compId : *island) {
+                    if(!isPending(compId)) {
+                        continue;
+                    }
+                    const auto compTerminals = view.getTerminals(compId);
+                    Seed seed{ D::None, compId, 0 };
+                    for(std::uint32_t t = 0; t < compTerminals.size(); ++t) {
+                        //Non-terminal connections are not visited yet, so they are None here
+                        const auto direction = m_connDirections.get(compTerminals[t]);
+                        if(direction > seed.direction) {
+                            seed.direction = direction;
+                            seed.terminal = t;
+                        }
+                    }
+                    if(seed.direction != D::None) {
+                        seeds.emplace_back(seed);
+                    }
+                }
+                std::sort(seeds.begin(), seeds.end(), [](const Seed& a, const Seed& b) {
+                        return (a.direction != b.direction) ? a.direction > b.direction : a.component < b.component;
+                        });
+                for(const auto& seed : seeds) {
+                    visit(seed.component, seed.direction, seed.terminal);
+                }
+            }
+
+            while(!queue.empty()) {
+                const auto connId = queue.front();
+                queue.pop_front();
+                const auto connDirection = m_connDirections.get(connId);
+
+                for(const auto& pin : view.getPins(connId)) {
+                    //Pins come in terminal order, so this is the first terminal facing connId
+                    if(isPending(pin.component)) {
+                        visit(pin.component, connDirection, pin.terminal);
+                    }
+                }
+            }
         }
 
-        Recommendation componentTraversal(const std::string& compName,
-                                            const std::set<std::string>& compPath,
-                                            const std::set<std::string>& connPath) {
+        //Components reachable from the touched components and connections without
+        //crossing circuit terminals, the islands whose recommendations they may change
+        std::vector<ComponentId> findAffectedComponents() {
+            const auto& view = getView();
+            std::vector<ComponentId> affected;
+            std::vector<ConnectionId> stack;
+            m_seen.clear(m_connections.size());
+            m_inIsland.clear(m_components.size());
+
+            for(const auto& term : getTerminalConnections()) {
+                m_seen[term.first] = true;
+            }
+
+            auto pushConnection = [&](ConnectionId connId) {
+                if(!m_seen.get(connId)) {
+                    m_seen[connId] = true;
+                    stack.emplace_back(connId);
+                }
+            };
+            auto addComponent = [&](ComponentId compId) {
+                if(!m_inIsland.get(compId)) {
+                    m_inIsland[compId] = true;
+                    affected.emplace_back(compId);
+                    for(const auto termConn : view.getTerminals(compId)) {
+                        pushConnection(termConn);
+                    }
+                }
+            };
 
-            auto& compObj = getComponentObject(compName);
-            const auto& terminals = compObj.getTerminals();
+            for(const auto name : m_touchedComponents) {
+                if(m_symbolToComponent[name] != g_invalidId) {
+                    addComponent(m_symbolToComponent[name]);
+                }
+            }
+            for(const auto connId : m_touchedConnections) {
+                pushConnection(connId);
+            }
 
-            std::set<std::string> compPathNext = compPath;
-            compPathNext.emplace(compName);
+            while(!stack.empty()) {
+                const auto connId = stack.back();
+                stack.pop_back();
+                for(const auto& pin : view.getPins(connId)) {
+                    addComponent(pin.component);
+                }
+            }
+            return affected;
+        }
 
-            Recommendation recomm;
-            for(const auto& term : terminals) {
-                const auto& connName = term.getConnection();
-                if(connPath.find(connName) == connPath.end()) {
-                    recomm = connectionTraversal(connName, compPathNext, connPath);
-                    recomm.setReferenceTerminal(term.getName());
+        //Name of the core component after the pending modifications. Only looks
+        //for it again if one of them may have replaced the current one.
+        SymbolId findModifiedCoreComponent() const {
+            const auto typeQ = m_symbols.find("Q");
+            const auto typeX = m_symbols.find("X");
+            auto mayReplaceCore = [&](SymbolId name) {
+                const auto compId = m_symbolToComponent[name];
+                const bool isCandidate = compId != g_invalidId &&
+                    (m_components[compId].getType() == typeQ || m_components[compId].getType() == typeX);
+                if(name == m_coreComponent) {
+                    return !isCandidate;
                 }
+                return isCandidate && (m_coreComponent == g_invalidId || getName(name) < getName(m_coreComponent));
+            };
+
+            if(std::none_of(m_touchedComponents.begin(), m_touchedComponents.end(), mayReplaceCore)) {
+                return m_coreComponent;
             }
+            const auto* coreComp = findCoreComponent();
+            return (coreComp == nullptr) ? g_invalidId : coreComp->getName();
+        }
+
+        //Terminal arrays are carved out of m_arena, replaced ones are only
+        //reclaimed when the whole graph is cleared or destroyed
+        Range<ConnectionId> allocateTerminals(std::size_t count) {
+            auto* const data = static_cast<ConnectionId*>(m_arena.allocate(std::max<std::size_t>(count, 1) * sizeof(ConnectionId),
+                                                                            alignof(ConnectionId)));
+            return Range<ConnectionId>(data, data + count);
+        }
 
-            if(recomm != Recommendation()) {
-                auto& comp = const_cast<Component&>(compObj);
-                comp.setRecommendation(recomm);
+        Range<ConnectionId> makeTerminals(const std::vector<std::string_view>& connections) {
+            const auto terminals = allocateTerminals(connections.size());
+            auto* dst = const_cast<ConnectionId*>(terminals.begin());
+            for(const auto& connName : connections) {
+                *dst++ = updateConnection(intern(connName));
             }
+            return terminals;
+        }
+
+        Range<ConnectionId> copyTerminals(Range<ConnectionId> connections) {
+            const auto terminals = allocateTerminals(connections.size());
+            std::copy(connections.begin(), connections.end(), const_cast<ConnectionId*>(terminals.begin()));
+            return terminals;
+        }
+
+        ComponentId appendComponent(SymbolId type,
+                SymbolId name,
+                SymbolId value,
+                Range<ConnectionId> terminals) {
+            const auto compId = static_cast<ComponentId>(m_components.size());
+            m_symbolToComponent[name] = compId;
+            m_components.emplace_back(type, name, value, terminals);
+            m_frozen = false;
+            return compId;
+        }
 
-            return recomm;
+        void touchComponent(const Component& comp) {
+            m_touchedComponents.emplace_back(comp.getName());
+            m_touchedConnections.insert(m_touchedConnections.end(), comp.getTerminals().begin(), comp.getTerminals().end());
+        }
+
+        CircuitGraph(TSchematicInterface * const schIfc,
+                     TProgressInterface * const progressIfc,
+                     std::shared_ptr<SubcircuitTable> subcircuits)
+            : m_arena(m_arenaBlock),
+            m_subcircuits(std::move(subcircuits)),
+            m_coreComponent(g_invalidId),
+            m_coreKnown(false),
+            m_componentWalks(WalkEntry{ WalkState::New, 0, Recommendation() }),
+            m_connectionWalks(WalkEntry{ WalkState::New, 0, Recommendation() }),
+            m_connDirections(Recommendation::Direction::None),
+            m_visited(false),
+            m_inIsland(false),
+            m_seen(false),
+            m_frozen(false),
+            m_rebuildView(true),
+            m_schIfc(schIfc),
+            m_progressIfc(progressIfc) {
         }
 
         public:
         CircuitGraph(TSchematicInterface * const schIfc, TProgressInterface * const progressIfc)
-            : m_schIfc(schIfc), m_progressIfc(progressIfc) {
+            : CircuitGraph(schIfc, progressIfc, std::make_shared<SubcircuitTable>()) {
         }
 
         virtual ~CircuitGraph() = default;
@@ -310,76 +722,397 @@ namespace circuit {
                 throw std::runtime_error(std::string("Wrong number of terminals (") +
                         std::to_string(size) + std::string(" != ") + std::to_string(N) + std::string(")!"));
             } else {
+                typedef Recommendation::Direction D;
                 auto it = initL.begin();
-                m_circuitTerminals = {  {*std::next(it, 0), Recommendation("UP")},
-                                        {*std::next(it, 1), Recommendation("DOWN")},
-                                        {*std::next(it, 2), Recommendation("LEFT")},
-                                        {*std::next(it, 3), Recommendation("RIGHT")}
+                m_circuitTerminals = {  {intern(*std::next(it, 0)), Recommendation(D::Up)},
+                                        {intern(*std::next(it, 1)), Recommendation(D::Down)},
+                                        {intern(*std::next(it, 2)), Recommendation(D::Left)},
+                                        {intern(*std::next(it, 3)), Recommendation(D::Right)}
                                     };
             }
         }
 
+        std::string_view getName(SymbolId id) const {
+            return m_symbols.getName(id);
+        }
+
+        //Connections of the circuit terminals present in the circuit, with their recommendations
+        std::vector<std::pair<ConnectionId, Recommendation>> getTerminalConnections() const {
+            std::vector<std::pair<ConnectionId, Recommendation>> terminals;
+            for(const auto& term : m_circuitTerminals) {
+                const auto connId = m_symbolToConnection[term.first];
+                if(connId != g_invalidId) {
+                    terminals.emplace_back(connId, term.second);
+                }
+            }
+            return terminals;
+        }
+
+        const std::vector<Component>& getComponents() const {
+            return m_components;
+        }
+
+        const std::vector<Connection>& getConnections() const {
+            return m_connections;
+        }
+
         const Connection& getConnectionObject(const std::string& name) const {
-            return getObject<Connection>(m_connectionMap, name);
+            return getObject<Connection>(m_connections, m_symbolToConnection, name);
         }
 
         const Component& getComponentObject(const std::string& name) const {
-            return getObject<Component>(m_componentMap, name);
+            return getObject<Component>(m_components, m_symbolToComponent, name);
         }
 
-        void addComponent(const std::string& type,
-                const std::string& name,
-                const std::string& value,
-                const std::list<std::string>& connections) {
-            auto compObj = Component(type, name, value, connections);
-            m_componentMap.emplace(name, compObj);
+        void addComponent(std::string_view type,
+                std::string_view name,
+                std::string_view value,
+                const std::vector<std::string_view>& connections) {
+            const auto nameId = intern(name);
+            if(m_symbolToComponent[nameId] != g_invalidId) {
+                logging::info("Duplicate component '", name, "' ignored");
+                m_duplicates.insert(nameId);
+                return;
+            }
 
-            for(const auto& connName : connections) {
-                auto& connObj = updateConnection(connName);
-                connObj.attachComponent(name);
+            const auto typeId = intern(type);
+            const auto valueId = intern(value);
+            m_rebuildView = true;
+            appendComponent(typeId, nameId, valueId, makeTerminals(connections));
+        }
+
+        //Id based construction, used to restore a circuit without parsing.
+        //Returns g_invalidId when a component of that name already exists.
+        ComponentId addComponent(SymbolId type,
+                SymbolId name,
+                SymbolId value,
+                Range<ConnectionId> terminals) {
+            if(m_symbolToComponent.at(name) != g_invalidId) {
+                return g_invalidId;
+            }
+
+            m_rebuildView = true;
+            return appendComponent(type, name, value, copyTerminals(terminals));
+        }
+
+        //g_invalidId if there is no component of that name
+        ComponentId findComponent(std::string_view name) const {
+            const auto nameId = m_symbols.find(name);
+            return (nameId == g_invalidId) ? g_invalidId : m_symbolToComponent[nameId];
+        }
+
+        bool hasComponent(std::string_view name) const {
+            const auto nameId = m_symbols.find(name);
+            return nameId != g_invalidId && m_symbolToComponent[nameId] != g_invalidId;
+        }
+
+        //True if more than one line defined a component named 'name'
+        bool isDuplicated(std::string_view name) const {
+            const auto nameId = m_symbols.find(name);
+            return nameId != g_invalidId && m_duplicates.count(nameId) != 0;
+        }
+
+        void addDuplicate(SymbolId name) {
+            m_duplicates.insert(name);
+        }
+
+        const std::unordered_set<SymbolId>& getDuplicates() const {
+            return m_duplicates;
+        }
+
+        //Adds the component or, if one of that name exists, replaces it in place
+        void updateComponent(std::string_view type,
+                std::string_view name,
+                std::string_view value,
+                const std::vector<std::string_view>& connections) {
+            const auto nameId = intern(name);
+            const auto typeId = intern(type);
+            const auto valueId = intern(value);
+            const auto terminals = makeTerminals(connections);
+
+            const auto compId = m_symbolToComponent[nameId];
+            if(compId == g_invalidId) {
+                touchComponent(m_components[appendComponent(typeId, nameId, valueId, terminals)]);
+                return;
             }
+
+            touchComponent(m_components[compId]);
+            m_components[compId] = Component(typeId, nameId, valueId, terminals);
+            touchComponent(m_components[compId]);
+            m_frozen = false;
+        }
+
+        //The last component takes the place of the removed one, so component ids
+        //stay dense. Connections are kept even if nothing is attached to them.
+        bool removeComponent(std::string_view name) {
+            const auto nameId = m_symbols.find(name);
+            if(nameId == g_invalidId || m_symbolToComponent[nameId] == g_invalidId) {
+                return false;
+            }
+
+            const auto compId = m_symbolToComponent[nameId];
+            touchComponent(m_components[compId]);
+            if(compId + 1 != m_components.size()) {
+                //Its pins change order, which may change its reference terminal
+                touchComponent(m_components.back());
+                m_components[compId] = std::move(m_components.back());
+                m_symbolToComponent[m_components[compId].getName()] = compId;
+            }
+            m_components.pop_back();
+            m_symbolToComponent[nameId] = g_invalidId;
+            m_frozen = false;
+            return true;
+        }
+
+        SymbolId addSymbol(std::string_view name) {
+            return intern(name);
+        }
+
+        ConnectionId addConnection(SymbolId name) {
+            return updateConnection(name);
+        }
+
+        void setRecommendation(ComponentId id, const Recommendation& recomm) {
+            m_components.at(id).setRecommendation(recomm);
+        }
+
+        void setPosition(ComponentId id, const GridPosition& position) {
+            m_components[id].setPosition(position);
+        }
+
+        void reserve(std::size_t symbols, std::size_t components, std::size_t connections) {
+            m_symbols.reserve(symbols);
+            m_symbolToComponent.reserve(symbols);
+            m_symbolToConnection.reserve(symbols);
+            m_components.reserve(components);
+            m_connections.reserve(connections);
+        }
+
+        void clear() {
+            m_circuitTerminals.clear();
+            m_symbols.clear();
+            m_components.clear();
+            m_connections.clear();
+            m_symbolToComponent.clear();
+            m_symbolToConnection.clear();
+            m_dependencies.clear();
+            m_duplicates.clear();
+            m_expansions.clear();
+            m_subcircuits = std::make_shared<SubcircuitTable>();
+            m_touchedComponents.clear();
+            m_touchedConnections.clear();
+            m_coreComponent = g_invalidId;
+            m_coreKnown = false;
+            m_view.clear();
+            m_arena.release();
+            m_frozen = false;
+            m_rebuildView = true;
+        }
+
+        std::size_t getSymbolsCount() const {
+            return m_symbols.size();
+        }
+
+        //Absolute paths of files included by the netlist (.include, .lib), directly or not
+        void addDependency(std::string_view path) {
+            if(std::find(m_dependencies.begin(), m_dependencies.end(), path) == m_dependencies.end()) {
+                m_dependencies.emplace_back(path);
+            }
+        }
+
+        const std::vector<std::string>& getDependencies() const {
+            return m_dependencies;
+        }
+
+        void addSubcircuit(std::shared_ptr<const SubcircuitDefinition> def) {
+            const auto name = std::string(def->getName());
+            if(!m_subcircuits->add(std::move(def))) {
+                logging::info("Duplicate subcircuit '", name, "' ignored");
+            }
+        }
+
+        const SubcircuitTable& getSubcircuits() const {
+            return *m_subcircuits;
+        }
+
+        //Definition instantiated by component 'compId', nullptr if it is no instance of a known subcircuit
+        const SubcircuitDefinition* getSubcircuit(ComponentId compId) const {
+            const auto& comp = m_components.at(compId);
+            const auto type = getName(comp.getType());
+            if(type.size() != 1 || ::toupper(static_cast<unsigned char>(type.front())) != 'X') {
+                return nullptr;
+            }
+            return m_subcircuits->find(getName(comp.getValue()));
+        }
+
+        //Circuit of the subcircuit instantiated by component 'compId', built on first
+        //use and shared by all instances of the definition, so memory grows with the
+        //definitions expanded, not with the instances. Nested instances are expanded
+        //the same way, one level per call. Returns nullptr if 'compId' instantiates
+        //no known subcircuit. Not synchronized, the thread owning the circuit calls it.
+        CircuitGraph* expand(ComponentId compId) {
+            const auto* def = getSubcircuit(compId);
+            if(def == nullptr) {
+                return nullptr;
+            }
+
+            auto& child = m_expansions[def];
+            if(!child) {
+                child.reset(new CircuitGraph(m_schIfc, m_progressIfc, m_subcircuits));
+                std::vector<std::string_view> connections;
+                def->forEachComponent([&](const std::vector<std::string_view>& tokens) {
+                        const auto& name = tokens.front();
+                        connections.assign(tokens.begin() + 1, tokens.begin() + std::max<std::size_t>(tokens.size(), 2) - 1);
+                        child->addComponent(name.substr(0, 1), name, tokens.back(), connections);
+                        });
+                child->freeze();
+                logging::debug("Subcircuit '", def->getName(), "' expanded, ", def->getComponentsCount(), " components");
+            }
+            return child.get();
+        }
+
+        //Builds the CSR adjacency used by traversal, printing and layout.
+        //Has to be called once parsing is complete. Modifications made by
+        //updateComponent() and removeComponent() are patched into the view,
+        //until there are too many of them.
+        void freeze() {
+            if(!m_rebuildView && m_view.getPatchesCount() + m_touchedConnections.size() < m_components.size() / m_patchRatio) {
+                std::vector<ComponentId> changed;
+                for(const auto name : m_touchedComponents) {
+                    if(m_symbolToComponent[name] != g_invalidId) {
+                        changed.emplace_back(m_symbolToComponent[name]);
+                    }
+                }
+                m_view.update(m_components, m_connections.size(), std::move(changed));
+            } else {
+                m_view.build(m_components, m_connections.size());
+                m_rebuildView = false;
+            }
+            m_frozen = true;
+        }
+
+        const GraphView& getView() const {
+            if(!m_frozen) {
+                throw std::runtime_error("Circuit graph is not frozen!");
+            }
+            return m_view;
         }
 
         void createRecomendations() {
-            auto& coreComp = getCoreComponent();
-            std::cout << coreComp.getType() << "  " << coreComp.getName() << "  " << coreComp.getValue()  << std::endl;
+            m_coreComponent = g_invalidId;
+            if(const auto* coreComp = findCoreComponent()) {
+                logging::debug(getName(coreComp->getType()), "  ", getName(coreComp->getName()), "  ", getName(coreComp->getValue()));
+                m_coreComponent = coreComp->getName();
+            }
+            m_coreKnown = true;
+
+            for(auto& comp : m_components) {
+                comp.setRecommendation(Recommendation());
+            }
+            propagateRecommendations();
+            m_touchedComponents.clear();
+            m_touchedConnections.clear();
+        }
+
+        //Recreates recommendations only where updateComponent() or removeComponent()
+        //may have changed them. The traversal never crosses circuit terminals, so
+        //components not connected to a modified one without crossing them keep theirs,
+        //and the update costs as much as the islands of the modified components.
+        //'changed' gets the components added or replaced since and those whose
+        //recommendation differs from the previous one, in ascending id order.
+        //'removed' gets the names of the components removed since.
+        //Recommendations restored from the cache, or a modification replacing
+        //the core component, recreate all of them.
+        void updateRecommendations(std::vector<ComponentId>& changed, std::vector<SymbolId>& removed) {
+            std::vector<ComponentId> touched;
+            removed.clear();
+            for(const auto name : m_touchedComponents) {
+                if(m_symbolToComponent[name] != g_invalidId) {
+                    touched.emplace_back(m_symbolToComponent[name]);
+                } else {
+                    removed.emplace_back(name);
+                }
+            }
+            std::sort(touched.begin(), touched.end());
+            touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+            std::sort(removed.begin(), removed.end());
+            removed.erase(std::unique(removed.begin(), removed.end()), removed.end());
+
+            //Components whose recommendation may change, with the ones they had
+            std::vector<ComponentId> affected;
+            const bool isFull = !m_coreKnown || findModifiedCoreComponent() != m_coreComponent;
+            if(isFull) {
+                affected.resize(m_components.size());
+                for(ComponentId compId = 0; compId < m_components.size(); ++compId) {
+                    affected[compId] = compId;
+                }
+            } else {
+                affected = findAffectedComponents();
+            }
+            std::vector<Recommendation> previous;
+            previous.reserve(affected.size());
+            for(const auto compId : affected) {
+                previous.emplace_back(m_components[compId].getRecommendation());
+            }
+
+            if(isFull) {
+                createRecomendations();
+            } else {
+                for(const auto compId : affected) {
+                    m_components[compId].setRecommendation(Recommendation());
+                }
+                propagateRecommendations(&affected);
+                m_touchedComponents.clear();
+                m_touchedConnections.clear();
+            }
 
-            componentTraversal(coreComp.getName(), {}, {});
+            changed.clear();
+            for(std::size_t i = 0; i < affected.size(); ++i) {
+                const auto compId = affected[i];
+                const auto& recomm = m_components[compId].getRecommendation();
+                if(recomm != previous[i] || recomm.getReferenceTerminalIndex() != previous[i].getReferenceTerminalIndex() ||
+                        std::binary_search(touched.begin(), touched.end(), compId)) {
+                    changed.emplace_back(compId);
+                }
+            }
+            std::sort(changed.begin(), changed.end());
         }
 
         void print() const {
-            for(const auto& compPair : m_componentMap) {
-                const auto& rootCompName = compPair.first;
-                const auto& rootComp = compPair.second;
+            if constexpr(!logging::isEnabled(logging::Level::Debug)) {
+                return;
+            }
 
-                std::cout << std::endl << "For component: " << rootCompName << std::endl;
-                const auto& terminals = rootComp.getTerminals();
-                for(const auto& term : terminals) {
-                    std::cout << "    term: " << term.getName() << " conname: " << term.getConnection() << std::endl;
-                    const auto& connObj = getConnectionObject(term.getConnection());
-                    for(const auto& compName : connObj.getComponents()) {
-                        const auto& compObj = getComponentObject(compName);
-                        std::cout << "      compname: " << compObj.getName()
-                            << "\t(" << compObj.getValue() << ")" << std::endl;
+            const auto& view = getView();
+            for(ComponentId rootId = 0; rootId < m_components.size(); ++rootId) {
+                logging::debug("For component: ", getName(m_components[rootId].getName()));
+                const auto terminals = view.getTerminals(rootId);
+                for(std::size_t termIdx = 0; termIdx < terminals.size(); ++termIdx) {
+                    const auto& connObj = m_connections[terminals[termIdx]];
+                    logging::debug("    term: ", Component::getTerminalName(termIdx), " conname: ", getName(connObj.getName()));
+                    for(const auto& pin : view.getPins(terminals[termIdx])) {
+                        const auto& compObj = m_components[pin.component];
+                        logging::debug("      compname: ", getName(compObj.getName()),
+                            "\t(", getName(compObj.getValue()), ")");
                     }
                 }
             }
         }
 
         void printRecommendations() const {
-            for(const auto& compPair : m_componentMap) {
-                const auto& rootCompName = compPair.first;
-                const auto& rootComp = compPair.second;
+            if constexpr(!logging::isEnabled(logging::Level::Info)) {
+                return;
+            }
+
+            for(const auto& rootComp : m_components) {
                 const auto& recomm = rootComp.getRecommendation();
 
-                std::cout << std::endl
-                          << "Component: "
-                          << rootCompName
-                          << "\tR:"
-                          << recomm.getName()
-                          << "\tRefT:"
-                          << recomm.getReferenceTerminal()
-                          << std::endl;
+                logging::info("Component: ",
+                              getName(rootComp.getName()),
+                              "\tR:",
+                              recomm.getName(),
+                              "\tRefT:",
+                              recomm.getReferenceTerminal());
             }
         }
 
@@ -0,0 +1,476 @@
+#ifndef CIRCUIT_CACHE
+#define CIRCUIT_CACHE
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <stdexcept>
+#include <circuit.hpp>
+#include <mapped_file.hpp>
+#include <file_utils.hpp>
+#include <logger.hpp>
+#include <version.hpp>
+
+namespace circuit {
+
+    //On-disk cache of processed circuits (symbols, components, connections
+    //and recommendations), keyed by netlist content hash and tool version.
+    //
+    //File layout, native byte order, every section 8-byte aligned:
+    //  Header
+    //  uint32_t          symbol offsets [symbolsCount + 1]
+    //  char              symbol characters
+    //  uint32_t          connection name symbols [connectionsCount]
+    //  ComponentRecord   [componentsCount]
+    //  uint32_t          terminal connections [terminalsCount]
+    //  DependencyRecord  [dependenciesCount]
+    //  char              dependency paths
+    //  uint32_t          names of duplicated components [duplicatesCount]
+    //  SubcircuitRecord  [subcircuitsCount]
+    //  uint32_t          subcircuit token ends [subcircuitTokensCount]
+    //  uint32_t          subcircuit line ends [subcircuitLinesCount]
+    //  char              subcircuit characters
+    template<typename TCircuitGraph>
+    class CircuitCache {
+
+        static constexpr char m_magic[8] = { 'S', 'V', 'C', 'A', 'C', 'H', 'E', '\0' };
+        static constexpr std::uint32_t m_formatVersion = 5;
+        static constexpr std::size_t m_alignment = 8;
+
+        struct Header {
+            char magic[8];
+            std::uint32_t formatVersion;
+            std::uint32_t headerSize;
+            char toolVersion[16];
+            std::uint64_t contentHash;
+            std::uint64_t symbolCharsCount;
+            std::uint64_t dependencyCharsCount;
+            std::uint64_t subcircuitCharsCount;
+            std::uint32_t symbolsCount;
+            std::uint32_t connectionsCount;
+            std::uint32_t componentsCount;
+            std::uint32_t terminalsCount;
+            std::uint32_t dependenciesCount;
+            std::uint32_t duplicatesCount;
+            std::uint32_t subcircuitsCount;
+            std::uint32_t subcircuitTokensCount;
+            std::uint32_t subcircuitLinesCount;
+            std::uint32_t reserved;
+        };
+
+        struct ComponentRecord {
+            std::uint32_t type;
+            std::uint32_t name;
+            std::uint32_t value;
+            std::uint32_t firstTerminal;
+            std::uint32_t terminalsCount;
+            std::uint32_t referenceTerminal;
+            std::uint32_t direction;
+            std::uint32_t reserved;
+        };
+
+        struct DependencyRecord {
+            std::uint64_t contentHash;
+            std::uint32_t pathOffset;
+            std::uint32_t pathLength;
+            std::uint32_t exists;
+            std::uint32_t reserved;
+        };
+
+        //Sizes of the arrays of one SubcircuitDefinition, stored back to back per definition
+        struct SubcircuitRecord {
+            std::uint64_t charsCount;
+            std::uint32_t tokensCount;
+            std::uint32_t linesCount;
+        };
+
+        //Bounds checked sequential access to the mapped cache file
+        class Cursor {
+            std::string_view m_data;
+            std::size_t m_pos;
+
+            public:
+            Cursor(std::string_view data)
+                : m_data(data), m_pos(0) {}
+
+            template<typename T>
+            const T* take(std::uint64_t count) {
+                m_pos = (m_pos + m_alignment - 1) / m_alignment * m_alignment;
+                if(m_pos > m_data.size() || count > (m_data.size() - m_pos) / sizeof(T)) {
+                    throw std::runtime_error("truncated file");
+                }
+                const auto* ptr = reinterpret_cast<const T*>(m_data.data() + m_pos);
+                m_pos += count * sizeof(T);
+                return ptr;
+            }
+        };
+
+        std::string m_cacheDir;
+        std::string m_netlist;
+        std::uint64_t m_contentHash;
+        bool m_enabled;
+
+        template<typename T>
+        static void append(std::string& out, const T* data, std::size_t count) {
+            out.append(reinterpret_cast<const char*>(data), count * sizeof(T));
+        }
+
+        static void align(std::string& out) {
+            out.resize((out.size() + m_alignment - 1) / m_alignment * m_alignment, '\0');
+        }
+
+        std::string getCachePath() const {
+            char hash[17];
+            std::snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(m_contentHash));
+            return (std::filesystem::path(m_cacheDir) / (std::string(hash) + "-" + app::g_version + ".svcache")).string();
+        }
+
+        static void fail(const std::string& what) {
+            throw std::runtime_error(std::string("Invalid netlist cache: ") + what);
+        }
+
+        bool isDependencyValid(const DependencyRecord& dep, const char* depChars) const {
+            const std::string path(depChars + dep.pathOffset, dep.pathLength);
+            std::uint64_t hash = 0;
+            const bool exists = file_reader::hashFile(file_reader::resolveIncludePath(m_netlist, path), hash);
+            return (exists == (dep.exists != 0)) && (!exists || hash == dep.contentHash);
+        }
+
+        //Validates the cache, then restores 'circuit' from it
+        bool restore(std::string_view data, TCircuitGraph& circuit) const {
+            Cursor cur(data);
+            const auto& hdr = *cur.template take<Header>(1);
+            if(std::memcmp(hdr.magic, m_magic, sizeof(m_magic)) != 0 ||
+                    hdr.formatVersion != m_formatVersion ||
+                    hdr.headerSize != sizeof(Header)) {
+                fail("unknown format");
+            }
+            if(std::strncmp(hdr.toolVersion, app::g_version, sizeof(hdr.toolVersion)) != 0 ||
+                    hdr.contentHash != m_contentHash) {
+                return false;
+            }
+
+            const auto* symOffsets = cur.template take<std::uint32_t>(std::uint64_t(hdr.symbolsCount) + 1);
+            const auto* symChars = cur.template take<char>(hdr.symbolCharsCount);
+            const auto* connNames = cur.template take<std::uint32_t>(hdr.connectionsCount);
+            const auto* comps = cur.template take<ComponentRecord>(hdr.componentsCount);
+            const auto* terminals = cur.template take<std::uint32_t>(hdr.terminalsCount);
+            const auto* deps = cur.template take<DependencyRecord>(hdr.dependenciesCount);
+            const auto* depChars = cur.template take<char>(hdr.dependencyCharsCount);
+            const auto* duplicates = cur.template take<std::uint32_t>(hdr.duplicatesCount);
+            const auto* subRecords = cur.template take<SubcircuitRecord>(hdr.subcircuitsCount);
+            const auto* subTokenEnds = cur.template take<std::uint32_t>(hdr.subcircuitTokensCount);
+            const auto* subLineEnds = cur.template take<std::uint32_t>(hdr.subcircuitLinesCount);
+            const auto* subChars = cur.template take<char>(hdr.subcircuitCharsCount);
+
+            for(std::uint32_t i = 0; i < hdr.symbolsCount; ++i) {
+                if(symOffsets[i] > symOffsets[i + 1] || symOffsets[i + 1] > hdr.symbolCharsCount) {
+                    fail("symbol table");
+                }
+            }
+
+            //Names have to be unique, otherwise restored ids would not match the stored ones
+            std::vector<bool> usedConn(hdr.symbolsCount, false);
+            std::vector<bool> usedComp(hdr.symbolsCount, false);
+            for(std::uint32_t i = 0; i < hdr.connectionsCount; ++i) {
+                if(connNames[i] >= hdr.symbolsCount || usedConn[connNames[i]]) {
+                    fail("connections");
+                }
+                usedConn[connNames[i]] = true;
+            }
+            for(std::uint32_t i = 0; i < hdr.componentsCount; ++i) {
+                const auto& c = comps[i];
+                if(c.type >= hdr.symbolsCount || c.name >= hdr.symbolsCount || c.value >= hdr.symbolsCount ||
+                        usedComp[c.name] ||
+                        c.firstTerminal > hdr.terminalsCount || c.terminalsCount > hdr.terminalsCount - c.firstTerminal ||
+                        (c.referenceTerminal != g_invalidId && c.referenceTerminal >= c.terminalsCount) ||
+                        c.direction > static_cast<std::uint32_t>(Recommendation::Direction::Up)) {
+                    fail("components");
+                }
+                usedComp[c.name] = true;
+            }
+            for(std::uint32_t i = 0; i < hdr.terminalsCount; ++i) {
+                if(terminals[i] >= hdr.connectionsCount) {
+                    fail("terminals");
+                }
+            }
+            for(std::uint32_t i = 0; i < hdr.duplicatesCount; ++i) {
+                if(duplicates[i] >= hdr.symbolsCount) {
+                    fail("duplicates");
+                }
+            }
+            for(std::uint32_t i = 0; i < hdr.dependenciesCount; ++i) {
+                if(deps[i].pathOffset > hdr.dependencyCharsCount ||
+                        deps[i].pathLength > hdr.dependencyCharsCount - deps[i].pathOffset) {
+                    fail("dependencies");
+                }
+                if(!isDependencyValid(deps[i], depChars)) {
+                    logging::info("Netlist cache outdated, '", std::string_view(depChars + deps[i].pathOffset, deps[i].pathLength), "' changed");
+                    return false;
+                }
+            }
+
+            //Symbols and connections are re-created in stored order, so all ids match.
+            //Duplicate symbols are the only defect found after the circuit is modified.
+            circuit.reserve(hdr.symbolsCount, hdr.componentsCount, hdr.connectionsCount);
+            for(std::uint32_t i = 0; i < hdr.symbolsCount; ++i) {
+                if(circuit.addSymbol(std::string_view(symChars + symOffsets[i], symOffsets[i + 1] - symOffsets[i])) != i) {
+                    circuit.clear();
+                    fail("duplicate symbol");
+                }
+            }
+            for(std::uint32_t i = 0; i < hdr.connectionsCount; ++i) {
+                circuit.addConnection(connNames[i]);
+            }
+            for(std::uint32_t i = 0; i < hdr.componentsCount; ++i) {
+                const auto& c = comps[i];
+                const Range<ConnectionId> compTerminals(terminals + c.firstTerminal, terminals + c.firstTerminal + c.terminalsCount);
+                const auto compId = circuit.addComponent(c.type, c.name, c.value, compTerminals);
+
+                Recommendation recomm(static_cast<Recommendation::Direction>(c.direction));
+                recomm.setReferenceTerminal(c.referenceTerminal);
+                circuit.setRecommendation(compId, recomm);
+            }
+            for(std::uint32_t i = 0; i < hdr.dependenciesCount; ++i) {
+                circuit.addDependency(file_reader::resolveIncludePath(m_netlist, std::string_view(depChars + deps[i].pathOffset, deps[i].pathLength)));
+            }
+            for(std::uint32_t i = 0; i < hdr.duplicatesCount; ++i) {
+                circuit.addDuplicate(duplicates[i]);
+            }
+
+            std::uint64_t charsPos = 0;
+            std::uint64_t tokensPos = 0;
+            std::uint64_t linesPos = 0;
+            for(std::uint32_t i = 0; i < hdr.subcircuitsCount; ++i) {
+                const auto& rec = subRecords[i];
+                if(rec.charsCount > hdr.subcircuitCharsCount - charsPos ||
+                        rec.tokensCount > hdr.subcircuitTokensCount - tokensPos ||
+                        rec.linesCount > hdr.subcircuitLinesCount - linesPos) {
+                    circuit.clear();
+                    fail("subcircuits");
+                }
+                try {
+                    circuit.addSubcircuit(SubcircuitDefinition::restore(std::string_view(subChars + charsPos, rec.charsCount),
+                                                                        subTokenEnds + tokensPos, rec.tokensCount,
+                                                                        subLineEnds + linesPos, rec.linesCount));
+                } catch(const std::runtime_error& e) {
+                    circuit.clear();
+                    fail("subcircuits");
+                }
+                charsPos += rec.charsCount;
+                tokensPos += rec.tokensCount;
+                linesPos += rec.linesCount;
+            }
+            return true;
+        }
+
+        std::string serialize(const TCircuitGraph& circuit) const {
+            Header hdr;
+            std::memset(&hdr, 0, sizeof(hdr));
+            std::memcpy(hdr.magic, m_magic, sizeof(m_magic));
+            hdr.formatVersion = m_formatVersion;
+            hdr.headerSize = sizeof(Header);
+            std::strncpy(hdr.toolVersion, app::g_version, sizeof(hdr.toolVersion) - 1);
+            hdr.contentHash = m_contentHash;
+
+            std::vector<std::uint32_t> symOffsets(1, 0);
+            std::string symChars;
+            for(SymbolId id = 0; id < circuit.getSymbolsCount(); ++id) {
+                symChars.append(circuit.getName(id));
+                symOffsets.emplace_back(static_cast<std::uint32_t>(symChars.size()));
+            }
+
+            std::vector<std::uint32_t> connNames;
+            for(const auto& conn : circuit.getConnections()) {
+                connNames.emplace_back(conn.getName());
+            }
+
+            std::vector<ComponentRecord> comps;
+            std::vector<std::uint32_t> terminals;
+            for(const auto& comp : circuit.getComponents()) {
+                const auto& recomm = comp.getRecommendation();
+                ComponentRecord rec;
+                std::memset(&rec, 0, sizeof(rec));
+                rec.type = comp.getType();
+                rec.name = comp.getName();
+                rec.value = comp.getValue();
+                rec.firstTerminal = static_cast<std::uint32_t>(terminals.size());
+                rec.terminalsCount = static_cast<std::uint32_t>(comp.getTerminals().size());
+                rec.referenceTerminal = recomm.getReferenceTerminalIndex();
+                rec.direction = static_cast<std::uint32_t>(recomm.getDirection());
+                comps.emplace_back(rec);
+                terminals.insert(terminals.end(), comp.getTerminals().begin(), comp.getTerminals().end());
+            }
+
+            std::vector<DependencyRecord> deps;
+            std::string depChars;
+            //Stored relative to the netlist, so copies of a netlist elsewhere find their own includes
+            const auto netlistDir = std::filesystem::path(file_reader::getAbsolutePath(m_netlist)).parent_path();
+            for(const auto& dependency : circuit.getDependencies()) {
+                auto path = std::filesystem::path(dependency).lexically_relative(netlistDir).string();
+                if(path.empty()) {
+                    path = dependency;
+                }
+
+                DependencyRecord rec;
+                std::memset(&rec, 0, sizeof(rec));
+                rec.exists = file_reader::hashFile(dependency, rec.contentHash) ? 1 : 0;
+                rec.pathOffset = static_cast<std::uint32_t>(depChars.size());
+                rec.pathLength = static_cast<std::uint32_t>(path.size());
+                depChars.append(path);
+                deps.emplace_back(rec);
+            }
+
+            hdr.symbolCharsCount = symChars.size();
+            hdr.dependencyCharsCount = depChars.size();
+            hdr.symbolsCount = static_cast<std::uint32_t>(circuit.getSymbolsCount());
+            hdr.connectionsCount = static_cast<std::uint32_t>(connNames.size());
+            hdr.componentsCount = static_cast<std::uint32_t>(comps.size());
+            hdr.terminalsCount = static_cast<std::uint32_t>(terminals.size());
+            hdr.dependenciesCount = static_cast<std::uint32_t>(deps.size());
+
+            const auto& dupSet = circuit.getDuplicates();
+            const std::vector<std::uint32_t> duplicates(dupSet.begin(), dupSet.end());
+            hdr.duplicatesCount = static_cast<std::uint32_t>(duplicates.size());
+
+            std::vector<SubcircuitRecord> subRecords;
+            std::vector<std::uint32_t> subTokenEnds;
+            std::vector<std::uint32_t> subLineEnds;
+            std::string subChars;
+            for(const auto& def : circuit.getSubcircuits().getDefinitions()) {
+                SubcircuitRecord rec;
+                std::memset(&rec, 0, sizeof(rec));
+                rec.charsCount = def->getChars().size();
+                rec.tokensCount = static_cast<std::uint32_t>(def->getTokenEnds().size());
+                rec.linesCount = static_cast<std::uint32_t>(def->getLineEnds().size());
+                subRecords.emplace_back(rec);
+                subChars.append(def->getChars());
+                subTokenEnds.insert(subTokenEnds.end(), def->getTokenEnds().begin(), def->getTokenEnds().end());
+                subLineEnds.insert(subLineEnds.end(), def->getLineEnds().begin(), def->getLineEnds().end());
+            }
+            hdr.subcircuitCharsCount = subChars.size();
+            hdr.subcircuitsCount = static_cast<std::uint32_t>(subRecords.size());
+            hdr.subcircuitTokensCount = static_cast<std::uint32_t>(subTokenEnds.size());
+            hdr.subcircuitLinesCount = static_cast<std::uint32_t>(subLineEnds.size());
+
+            std::string out;
+            append(out, &hdr, 1);
+            align(out);
+            append(out, symOffsets.data(), symOffsets.size());
+            align(out);
+            append(out, symChars.data(), symChars.size());
+            align(out);
+            append(out, connNames.data(), connNames.size());
+            align(out);
+            append(out, comps.data(), comps.size());
+            align(out);
+            append(out, terminals.data(), terminals.size());
+            align(out);
+            append(out, deps.data(), deps.size());
+            align(out);
+            append(out, depChars.data(), depChars.size());
+            align(out);
+            append(out, duplicates.data(), duplicates.size());
+            align(out);
+            append(out, subRecords.data(), subRecords.size());
+            align(out);
+            append(out, subTokenEnds.data(), subTokenEnds.size());
+            align(out);
+            append(out, subLineEnds.data(), subLineEnds.size());
+            align(out);
+            append(out, subChars.data(), subChars.size());
+            return out;
+        }
+
+        public:
+        CircuitCache(const std::string& cacheDir, const std::string& netlist)
+            : m_cacheDir(cacheDir), m_netlist(netlist), m_contentHash(0), m_enabled(false) {
+            if(m_cacheDir.empty()) {
+                return;
+            }
+
+            //Only regular files can be hashed up front, standard input and pipes are never cached
+            m_enabled = (m_netlist != "-") && file_reader::hashFile(m_netlist, m_contentHash);
+        }
+
+        virtual ~CircuitCache() = default;
+
+        //$SPICE_VISUALIZER_CACHE_DIR, then $XDG_CACHE_HOME or ~/.cache, empty disables caching
+        static std::string getDefaultDir() {
+            if(const char* dir = std::getenv("SPICE_VISUALIZER_CACHE_DIR")) {
+                return dir;
+            }
+            if(const char* dir = std::getenv("XDG_CACHE_HOME"); dir != nullptr && *dir != '\0') {
+                return (std::filesystem::path(dir) / "spice_visualizer").string();
+            }
+            if(const char* dir = std::getenv("HOME"); dir != nullptr && *dir != '\0') {
+                return (std::filesystem::path(dir) / ".cache" / "spice_visualizer").string();
+            }
+            return std::string();
+        }
+
+        //Restores 'circuit' (has to be empty) from the cache, returns false on a cache miss
+        bool load(TCircuitGraph& circuit) const {
+            if(!m_enabled || circuit.getSymbolsCount() != 0) {
+                return false;
+            }
+
+            const auto path = getCachePath();
+            try {
+                file_reader::MappedFile file(path);
+                if(!file.isMapped() || !restore(file.getData(), circuit)) {
+                    return false;
+                }
+            } catch(const std::runtime_error& e) {
+                logging::info("Netlist cache '", path, "' ignored: ", e.what());
+                return false;
+            }
+
+            logging::info("Netlist '", m_netlist, "' restored from cache");
+            return true;
+        }
+
+        //Cache write failures are not fatal, they are only logged
+        void store(const TCircuitGraph& circuit) const {
+            if(!m_enabled) {
+                return;
+            }
+
+            //The netlist was hashed before it was parsed, an edit in between
+            //would store the old circuit under the new content
+            std::uint64_t contentHash = 0;
+            if(!file_reader::hashFile(m_netlist, contentHash) || contentHash != m_contentHash) {
+                logging::info("Netlist '", m_netlist, "' changed while processed, cache not written");
+                return;
+            }
+
+            const auto path = getCachePath();
+            const auto tmpPath = path + ".tmp" + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+            try {
+                std::filesystem::create_directories(m_cacheDir);
+                const auto data = serialize(circuit);
+                {
+                    std::ofstream ofs(tmpPath, std::ios::binary | std::ios::trunc);
+                    ofs.write(data.data(), data.size());
+                    if(!ofs) {
+                        throw std::runtime_error(std::string("File write error '") + tmpPath + std::string("'"));
+                    }
+                }
+                std::filesystem::rename(tmpPath, path);
+            } catch(const std::exception& e) {
+                std::error_code ec;
+                std::filesystem::remove(tmpPath, ec);
+                logging::info("Netlist cache '", path, "' not written: ", e.what());
+            }
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef CIRCUIT_EXPORT
+#define CIRCUIT_EXPORT
+
+#include <string>
+#include <fstream>
+#include <stdexcept>
+
+namespace circuit {
+
+    //Plain text export of a processed circuit, one line per component:
+    //component <name> <type> <value> <recommendation> <ref. terminal> <x> <y> <connections...>
+    //where x, y is the grid position of the reference terminal.
+    //Empty fields are written as '-'.
+    template<typename TCircuitGraph>
+    void exportCircuit(const TCircuitGraph& circuit, const std::string& netlist, const std::string& filename) {
+        auto field = [](const std::string& str) -> const std::string& {
+            static const std::string empty = "-";
+            return str.empty() ? empty : str;
+        };
+
+        std::string out;
+        out.append("# spice_visualizer export\n# netlist ").append(netlist).append("\n");
+
+        const auto& view = circuit.getView();
+        const auto& components = circuit.getComponents();
+        const auto& connections = circuit.getConnections();
+        for(ComponentId compId = 0; compId < components.size(); ++compId) {
+            const auto& comp = components[compId];
+            const auto& recomm = comp.getRecommendation();
+
+            out.append("component ").append(circuit.getName(comp.getName()));
+            out.append(" ").append(circuit.getName(comp.getType()));
+            out.append(" ").append(circuit.getName(comp.getValue()));
+            out.append(" ").append(field(recomm.getName()));
+            out.append(" ").append(field(recomm.getReferenceTerminal()));
+            out.append(" ").append(std::to_string(comp.getPosition().x));
+            out.append(" ").append(std::to_string(comp.getPosition().y));
+            for(const auto connId : view.getTerminals(compId)) {
+                out.append(" ").append(circuit.getName(connections[connId].getName()));
+            }
+            out.append("\n");
+        }
+
+        std::ofstream ofs(filename, std::ios::binary | std::ios::trunc);
+        if(!ofs.is_open()) {
+            throw std::runtime_error(std::string("File open error '") + filename + std::string("'"));
+        }
+        ofs.write(out.data(), out.size());
+        if(!ofs) {
+            throw std::runtime_error(std::string("File write error '") + filename + std::string("'"));
+        }
+    }
+}
+
+#endif
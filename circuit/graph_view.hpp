@@ -0,0 +1,251 @@
+#ifndef GRAPH_VIEW
+#define GRAPH_VIEW
+
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cstdint>
+
+namespace circuit {
+
+    typedef std::uint32_t ComponentId;
+    typedef std::uint32_t ConnectionId;
+
+    //Contiguous read-only slice of one of the GraphView arrays
+    template<typename T>
+    class Range {
+        const T* m_begin;
+        const T* m_end;
+
+        public:
+        Range(const T* begin, const T* end)
+            : m_begin(begin), m_end(end) {}
+
+        const T* begin() const {
+            return m_begin;
+        }
+
+        const T* end() const {
+            return m_end;
+        }
+
+        std::size_t size() const {
+            return static_cast<std::size_t>(m_end - m_begin);
+        }
+
+        const T& operator[](std::size_t idx) const {
+            return m_begin[idx];
+        }
+    };
+
+    //Terminal 'terminal' of component 'component'
+    struct Pin {
+        ComponentId component;
+        std::uint32_t terminal;
+    };
+
+    //Frozen adjacency of the circuit in compressed sparse row form:
+    //component -> terminal connections and connection -> component pins,
+    //each stored as one offsets array plus one flat payload array.
+    //Small modifications are kept as per object patches on top of the
+    //arrays until the next build().
+    class GraphView {
+        std::vector<std::uint32_t> m_termOffsets;
+        std::vector<ConnectionId> m_termConnections;
+
+        std::vector<std::uint32_t> m_pinOffsets;
+        std::vector<Pin> m_pins;
+
+        std::size_t m_componentsCount = 0;
+        std::size_t m_connectionsCount = 0;
+        std::unordered_map<ComponentId, std::vector<ConnectionId>> m_termPatches;
+        std::unordered_map<ConnectionId, std::vector<Pin>> m_pinPatches;
+
+        //Keeps lookups of unpatched objects off the hash maps
+        std::vector<bool> m_termPatched;
+        std::vector<bool> m_pinPatched;
+
+        public:
+        GraphView() = default;
+        virtual ~GraphView() = default;
+
+        //TComponents: random access container of objects providing getTerminals()
+        template<typename TComponents>
+        void build(const TComponents& components, std::size_t connectionsCount) {
+            const auto compCount = components.size();
+
+            m_componentsCount = compCount;
+            m_connectionsCount = connectionsCount;
+            m_termPatches.clear();
+            m_pinPatches.clear();
+            m_termPatched.clear();
+            m_pinPatched.clear();
+
+            m_termOffsets.assign(compCount + 1, 0);
+            m_pinOffsets.assign(connectionsCount + 1, 0);
+
+            for(std::size_t c = 0; c < compCount; ++c) {
+                const auto& terminals = components[c].getTerminals();
+                m_termOffsets[c + 1] = m_termOffsets[c] + static_cast<std::uint32_t>(terminals.size());
+                for(const auto connId : terminals) {
+                    ++m_pinOffsets[connId + 1];
+                }
+            }
+
+            for(std::size_t n = 0; n < connectionsCount; ++n) {
+                m_pinOffsets[n + 1] += m_pinOffsets[n];
+            }
+
+            m_termConnections.resize(m_termOffsets[compCount]);
+            m_pins.resize(m_pinOffsets[connectionsCount]);
+
+            //Pins of every connection end up in component order
+            std::vector<std::uint32_t> fill(m_pinOffsets.begin(), m_pinOffsets.end() - 1);
+            for(std::size_t c = 0; c < compCount; ++c) {
+                const auto& terminals = components[c].getTerminals();
+                auto* const dst = m_termConnections.data() + m_termOffsets[c];
+                for(std::uint32_t t = 0; t < terminals.size(); ++t) {
+                    const auto connId = terminals[t];
+                    dst[t] = connId;
+                    m_pins[fill[connId]++] = Pin{ static_cast<ComponentId>(c), t };
+                }
+            }
+        }
+
+        //Patches the view after terminals of components 'changed' (current ids) were
+        //modified, components were appended or components past the new end were
+        //dropped. Cost depends on the changed components and the connections they
+        //were or are attached to only.
+        template<typename TComponents>
+        void update(const TComponents& components, std::size_t connectionsCount, std::vector<ComponentId> changed) {
+            const auto compCount = components.size();
+            std::sort(changed.begin(), changed.end());
+            changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+
+            std::vector<ConnectionId> connections;
+            for(ComponentId id = static_cast<ComponentId>(compCount); id < m_componentsCount; ++id) {
+                const auto terminals = getTerminals(id);
+                connections.insert(connections.end(), terminals.begin(), terminals.end());
+            }
+            for(const auto id : changed) {
+                if(id < m_componentsCount) {
+                    const auto terminals = getTerminals(id);
+                    connections.insert(connections.end(), terminals.begin(), terminals.end());
+                }
+                if(id < compCount) {
+                    const auto& terminals = components[id].getTerminals();
+                    connections.insert(connections.end(), terminals.begin(), terminals.end());
+                }
+            }
+            std::sort(connections.begin(), connections.end());
+            connections.erase(std::unique(connections.begin(), connections.end()), connections.end());
+
+            //Components whose previous pins go away
+            std::vector<ComponentId> replaced;
+            for(const auto id : changed) {
+                if(id < std::min(compCount, m_componentsCount)) {
+                    replaced.emplace_back(id);
+                }
+            }
+            for(auto id = static_cast<ComponentId>(compCount); id < m_componentsCount; ++id) {
+                replaced.emplace_back(id);
+            }
+
+            //Pins are edited in place, in component order, so a modification of a
+            //connection with many pins, like a supply, costs a few moves of them
+            auto byComponent = [](const Pin& a, const Pin& b) {
+                return a.component < b.component;
+            };
+            for(const auto connId : connections) {
+                const bool isPatched = connId < m_pinPatched.size() && m_pinPatched[connId];
+                auto& pins = m_pinPatches[connId];
+                if(!isPatched) {
+                    const auto base = getPins(connId);
+                    pins.assign(base.begin(), base.end());
+                }
+                for(const auto id : replaced) {
+                    const auto range = std::equal_range(pins.begin(), pins.end(), Pin{ id, 0 }, byComponent);
+                    pins.erase(range.first, range.second);
+                }
+                for(const auto id : changed) {
+                    if(id >= compCount) {
+                        break;
+                    }
+                    const auto& terminals = components[id].getTerminals();
+                    for(std::uint32_t t = 0; t < terminals.size(); ++t) {
+                        if(terminals[t] == connId) {
+                            const Pin pin{ id, t };
+                            pins.insert(std::upper_bound(pins.begin(), pins.end(), pin, byComponent), pin);
+                        }
+                    }
+                }
+                if(connId >= m_pinPatched.size()) {
+                    m_pinPatched.resize(connId + 1, false);
+                }
+                m_pinPatched[connId] = true;
+            }
+
+            for(const auto id : changed) {
+                if(id < compCount) {
+                    const auto& terminals = components[id].getTerminals();
+                    m_termPatches[id].assign(terminals.begin(), terminals.end());
+                    if(id >= m_termPatched.size()) {
+                        m_termPatched.resize(id + 1, false);
+                    }
+                    m_termPatched[id] = true;
+                }
+            }
+            m_componentsCount = compCount;
+            m_connectionsCount = std::max(m_connectionsCount, connectionsCount);
+        }
+
+        //Number of patched objects, a rebuild pays off once it gets large
+        std::size_t getPatchesCount() const {
+            return m_termPatches.size() + m_pinPatches.size();
+        }
+
+        void clear() {
+            m_termOffsets.clear();
+            m_termConnections.clear();
+            m_pinOffsets.clear();
+            m_pins.clear();
+            m_termPatches.clear();
+            m_pinPatches.clear();
+            m_termPatched.clear();
+            m_pinPatched.clear();
+            m_componentsCount = 0;
+            m_connectionsCount = 0;
+        }
+
+        std::size_t getComponentsCount() const {
+            return m_componentsCount;
+        }
+
+        std::size_t getConnectionsCount() const {
+            return m_connectionsCount;
+        }
+
+        Range<ConnectionId> getTerminals(ComponentId id) const {
+            if(id < m_termPatched.size() && m_termPatched[id]) {
+                const auto& patch = m_termPatches.find(id)->second;
+                return Range<ConnectionId>(patch.data(), patch.data() + patch.size());
+            }
+            const auto* data = m_termConnections.data();
+            return Range<ConnectionId>(data + m_termOffsets[id], data + m_termOffsets[id + 1]);
+        }
+
+        Range<Pin> getPins(ConnectionId id) const {
+            if(id < m_pinPatched.size() && m_pinPatched[id]) {
+                const auto& patch = m_pinPatches.find(id)->second;
+                return Range<Pin>(patch.data(), patch.data() + patch.size());
+            }
+            if(id + 1 >= m_pinOffsets.size()) {
+                return Range<Pin>(nullptr, nullptr);
+            }
+            const auto* data = m_pins.data();
+            return Range<Pin>(data + m_pinOffsets[id], data + m_pinOffsets[id + 1]);
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,281 @@
+#ifndef NETLIST_UPDATER
+#define NETLIST_UPDATER
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <mapped_file.hpp>
+#include <parser_ngspice.hpp>
+#include <pipeline.hpp>
+#include <placement.hpp>
+#include <gui_progress_interface.hpp>
+#include <logger.hpp>
+
+namespace circuit {
+
+    //Applies edits of an already processed netlist to its circuit. The mapped
+    //new content is compared with the previous one, only the changed run of lines
+    //is re-parsed, applied component by component and spliced into the kept text. Edits touching section
+    //(.control, .subckt) or include lines fall back to full processing.
+    template<typename TCircuitGraph>
+    class NetlistUpdater {
+        typedef parsers::ParserNGSPICE<TCircuitGraph> TParser;
+        typedef typename TParser::LineKind LineKind;
+
+        static constexpr std::size_t m_compareBlock = 4096;
+
+        //Section and include lines of m_text
+        struct Marker {
+            std::size_t offset;
+            LineKind kind;
+        };
+
+        //Lines [begin, oldEnd) of the previous content replaced by [begin, newEnd) of the new one
+        struct Region {
+            std::size_t begin;
+            std::size_t oldEnd;
+            std::size_t newEnd;
+        };
+
+        std::string m_filename;
+        std::string m_text;
+
+        //Holds the new content when the file can not be mapped
+        std::string m_newText;
+        std::vector<Marker> m_markers;
+
+        //Components changed and names of those removed by the last incremental update
+        std::vector<ComponentId> m_changed;
+        std::vector<SymbolId> m_removed;
+
+        //Kept from one update to the next, so updates cost what they modify
+        std::unique_ptr<Placement<TCircuitGraph>> m_placement;
+
+        //Set while the circuit is being modified, an update failing halfway
+        //leaves it set and the next update processes the netlist from scratch.
+        //Set by invalidate() as well.
+        bool m_outdated;
+
+        //Reuses the memory of 'text', saving page faults on every update
+        static void readText(const std::string& filename, std::string& text) {
+            file_reader::MappedFile file(filename);
+            if(file.isMapped()) {
+                text.assign(file.getData());
+                return;
+            }
+
+            std::ifstream ifs(filename, std::ios::binary);
+            if(!ifs.is_open()) {
+                throw std::runtime_error(std::string("File open error '") + filename + std::string("'"));
+            }
+            text.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+        }
+
+        void scanMarkers() {
+            m_markers.clear();
+            std::size_t pos = 0;
+            while(pos < m_text.size()) {
+                const auto end = std::min(m_text.find('\n', pos), m_text.size());
+                const auto kind = TParser::getLineKind(std::string_view(m_text).substr(pos, end - pos));
+                if(kind != LineKind::Other) {
+                    m_markers.push_back({ pos, kind });
+                }
+                pos = end + 1;
+            }
+        }
+
+        static std::size_t findMismatch(std::string_view a, std::string_view b) {
+            const auto size = std::min(a.size(), b.size());
+            std::size_t pos = 0;
+            while(pos + m_compareBlock <= size && std::memcmp(a.data() + pos, b.data() + pos, m_compareBlock) == 0) {
+                pos += m_compareBlock;
+            }
+            while(pos < size && a[pos] == b[pos]) {
+                ++pos;
+            }
+            return pos;
+        }
+
+        static std::size_t findSuffix(std::string_view a, std::string_view b, std::size_t limit) {
+            std::size_t len = 0;
+            while(len + m_compareBlock <= limit &&
+                    std::memcmp(a.data() + a.size() - len - m_compareBlock,
+                                b.data() + b.size() - len - m_compareBlock, m_compareBlock) == 0) {
+                len += m_compareBlock;
+            }
+            while(len < limit && a[a.size() - len - 1] == b[b.size() - len - 1]) {
+                ++len;
+            }
+            return len;
+        }
+
+        //Smallest run of whole lines covering all differences
+        Region findRegion(std::string_view text) const {
+            const std::string_view old(m_text);
+            const auto mismatch = findMismatch(old, text);
+            const auto lineStart = old.substr(0, mismatch).rfind('\n');
+            const std::size_t begin = (lineStart == std::string_view::npos) ? 0 : lineStart + 1;
+
+            const auto suffix = findSuffix(old, text, std::min(old.size(), text.size()) - begin);
+            Region reg{ begin, old.size() - suffix, text.size() - suffix };
+
+            //Both ends have to be line starts, the common suffix makes them advance together
+            auto isLineStart = [&](std::string_view str, std::size_t end) {
+                return end == begin || end == str.size() || str[end - 1] == '\n';
+            };
+            while(!isLineStart(old, reg.oldEnd) || !isLineStart(text, reg.newEnd)) {
+                const auto nl = old.find('\n', reg.oldEnd);
+                const auto step = (nl == std::string_view::npos) ? old.size() - reg.oldEnd : nl + 1 - reg.oldEnd;
+                reg.oldEnd += step;
+                reg.newEnd += step;
+            }
+            return reg;
+        }
+
+        bool isIgnoredAt(std::size_t offset) const {
+            bool ignore = false;
+            for(const auto& marker : m_markers) {
+                if(marker.offset >= offset) {
+                    break;
+                }
+                if(marker.kind == LineKind::SectionBegin) {
+                    ignore = true;
+                } else if(marker.kind == LineKind::SectionEnd) {
+                    ignore = false;
+                }
+            }
+            return ignore;
+        }
+
+        bool isIncremental(const Region& reg, std::string_view text) const {
+            for(const auto& marker : m_markers) {
+                if(marker.offset >= reg.begin && marker.offset < reg.oldEnd) {
+                    return false;
+                }
+            }
+
+            auto region = text.substr(reg.begin, reg.newEnd - reg.begin);
+            while(!region.empty()) {
+                const auto end = std::min(region.find('\n'), region.size());
+                if(TParser::getLineKind(region.substr(0, end)) != LineKind::Other) {
+                    return false;
+                }
+                region.remove_prefix(std::min(end + 1, region.size()));
+            }
+            return true;
+        }
+
+        void restorePlacement(TCircuitGraph& circuit) {
+            m_placement.reset(new Placement<TCircuitGraph>(circuit));
+            m_placement->restore();
+        }
+
+        void reload(TCircuitGraph& circuit, std::string_view text, gui::GuiProgressInterfaceExtSync* const progressIfc) {
+            logging::info("Netlist '", m_filename, "' changed, processing it again");
+            progressIfc->show();
+            circuit.clear();
+            processNetlist(m_filename, circuit, progressIfc);
+            restorePlacement(circuit);
+            progressIfc->hide();
+
+            m_text.assign(text);
+            scanMarkers();
+            m_outdated = false;
+        }
+
+        public:
+        enum class Result {
+            Unchanged,
+            Incremental,
+            Full
+        };
+
+        NetlistUpdater(const std::string& filename)
+            : m_filename(filename), m_outdated(false) {}
+
+        virtual ~NetlistUpdater() = default;
+
+        //Takes the current file content as the one 'circuit' was processed from
+        void reset(TCircuitGraph& circuit) {
+            readText(m_filename, m_text);
+            scanMarkers();
+            restorePlacement(circuit);
+        }
+
+        //Makes the next update() process the netlist from scratch, e.g. after an included file changed
+        void invalidate() {
+            m_outdated = true;
+        }
+
+        //Valid after update() returned Result::Incremental, components placed again in ascending id order
+        const std::vector<ComponentId>& getChanged() const {
+            return m_changed;
+        }
+
+        //Valid after update() returned Result::Incremental
+        const std::vector<SymbolId>& getRemoved() const {
+            return m_removed;
+        }
+
+        Result update(TCircuitGraph& circuit, gui::GuiProgressInterfaceExtSync* const progressIfc) {
+            const auto start = std::chrono::steady_clock::now();
+            file_reader::MappedFile file(m_filename);
+            if(!file.isMapped()) {
+                readText(m_filename, m_newText);
+            }
+            const std::string_view text = file.isMapped() ? file.getData() : std::string_view(m_newText);
+            if(m_outdated) {
+                reload(circuit, text, progressIfc);
+                return Result::Full;
+            }
+
+            const auto reg = findRegion(text);
+            if(reg.oldEnd == reg.begin && reg.newEnd == reg.begin) {
+                return Result::Unchanged;
+            }
+
+            m_outdated = true;
+            bool incremental = isIncremental(reg, text);
+            if(incremental && !isIgnoredAt(reg.begin)) {
+                TParser parser(circuit);
+                incremental = parser.replaceLines(std::string_view(m_text).substr(reg.begin, reg.oldEnd - reg.begin),
+                                                  text.substr(reg.begin, reg.newEnd - reg.begin));
+                if(incremental) {
+                    circuit.freeze();
+                    circuit.updateRecommendations(m_changed, m_removed);
+                    if(!m_placement) {
+                        restorePlacement(circuit);
+                    }
+                    m_placement->update(m_changed, m_removed);
+                }
+            }
+
+            if(!incremental) {
+                reload(circuit, text, progressIfc);
+                return Result::Full;
+            }
+
+            for(auto& marker : m_markers) {
+                if(marker.offset >= reg.oldEnd) {
+                    marker.offset = marker.offset - reg.oldEnd + reg.newEnd;
+                }
+            }
+            m_text.replace(reg.begin, reg.oldEnd - reg.begin, text.substr(reg.begin, reg.newEnd - reg.begin));
+            m_outdated = false;
+
+            const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+            logging::info("Netlist '", m_filename, "' updated, ", reg.oldEnd - reg.begin, " bytes replaced by ",
+                          reg.newEnd - reg.begin, " in ", elapsed.count(), " ms");
+            return Result::Incremental;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef PIPELINE
+#define PIPELINE
+
+#include <string>
+#include <file_reader.hpp>
+#include <parser_ngspice.hpp>
+#include <gui_progress_interface.hpp>
+#include <gui_progress_phase.hpp>
+#include <circuit_cache.hpp>
+#include <placement.hpp>
+
+namespace circuit {
+
+    //Processing steps shared by the GUI processor thread and the batch mode.
+    //Processed circuits are cached in 'cacheDir' (empty disables the cache),
+    //a cache hit skips parsing and recommendations. Placement is not cached.
+    template<typename TCircuitGraph>
+    void processNetlist(const std::string& filename,
+                        TCircuitGraph& circuit,
+                        gui::GuiProgressInterfaceExtSync* const progressIfc,
+                        const std::string& cacheDir = CircuitCache<TCircuitGraph>::getDefaultDir()) {
+        bool cached = false;
+        CircuitCache<TCircuitGraph> cache(cacheDir, filename);
+        {
+            gui::ProgressPhase phase(progressIfc, "Checking netlist cache", 1);
+            cached = cache.load(circuit);
+        }
+
+        if(!cached) {
+            gui::ProgressPhase phase(progressIfc, "Reading and parsing netlist");
+            parsers::ParserNGSPICE<TCircuitGraph> parser(circuit, filename);
+            file_reader::FileReader<parsers::ParserInterface, gui::GuiProgressInterfaceExtSync> freader(&parser, progressIfc);
+            freader.readFile(filename);
+        }
+
+        {
+            gui::ProgressPhase phase(progressIfc, "Building circuit graph", 1);
+            circuit.freeze();
+        }
+
+        circuit.setTerminals( { "vdd", "vss", "gen", "out" } );
+        if(!cached) {
+            {
+                gui::ProgressPhase phase(progressIfc, "Creating placement recommendations",
+                                         static_cast<std::int32_t>(circuit.getComponents().size()));
+                circuit.createRecomendations();
+            }
+
+            gui::ProgressPhase phase(progressIfc, "Writing netlist cache", 1);
+            cache.store(circuit);
+        }
+
+        gui::ProgressPhase phase(progressIfc, "Placing components", 1);
+        Placement<TCircuitGraph>(circuit).run();
+    }
+
+    //Recommendations and placement of a circuit returned by expand(), which is
+    //laid out on its own with the same circuit terminals as the netlist
+    template<typename TCircuitGraph>
+    void processSubcircuit(TCircuitGraph& circuit) {
+        circuit.setTerminals( { "vdd", "vss", "gen", "out" } );
+        circuit.createRecomendations();
+        Placement<TCircuitGraph>(circuit).run();
+    }
+}
+
+#endif
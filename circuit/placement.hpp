@@ -0,0 +1,512 @@
+#ifndef PLACEMENT
+#define PLACEMENT
+
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <string_view>
+#include <algorithm>
+#include <cmath>
+#include <cctype>
+#include <cstdint>
+#include <circuit.hpp>
+
+namespace circuit {
+
+    //Turns recommendations into grid positions. Components are visited breadth
+    //first from the circuit terminals, each is put at the point its reference
+    //connection was last attached at, with its body on the side opposite to the
+    //recommended direction (an UP component hangs below its terminal). Overlaps
+    //are detected with a spatial hash of the occupied boxes and resolved by
+    //searching rings of positions around that point. Cost is near linear in the
+    //number of components, positions stay the same for the same circuit.
+    template<typename TCircuitGraph>
+    class Placement {
+        typedef Recommendation::Direction D;
+
+        //Symbol size in grid units, along the terminal axis and across it.
+        //Matches the symbols of gui_qt/schematic_component.hpp.
+        struct Footprint {
+            std::int32_t length;
+            std::int32_t width;
+        };
+
+        //Half-open, in grid units
+        struct Box {
+            std::int32_t x0;
+            std::int32_t y0;
+            std::int32_t x1;
+            std::int32_t y1;
+
+            bool intersects(const Box& other) const {
+                return x0 < other.x1 && other.x0 < x1 && y0 < other.y1 && other.y0 < y1;
+            }
+        };
+
+        //Buckets of m_bucketSize grid units, every box is listed in all buckets it covers.
+        //Boxes are indexed by component name, so they survive component ids changing.
+        class SpatialHash {
+            std::vector<Box> m_boxes;
+            std::unordered_map<std::uint64_t, std::vector<SymbolId>> m_buckets;
+
+            static bool isEmpty(const Box& box) {
+                return box.x0 >= box.x1;
+            }
+
+            static std::int32_t getBucket(std::int32_t coord) {
+                return (coord >= 0) ? coord / m_bucketSize : (coord - m_bucketSize + 1) / m_bucketSize;
+            }
+
+            static std::uint64_t getKey(std::int32_t bx, std::int32_t by) {
+                return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(bx)) << 32) | static_cast<std::uint32_t>(by);
+            }
+
+            template<typename TFun>
+            static void forEachBucket(const Box& box, TFun&& fun) {
+                for(auto bx = getBucket(box.x0); bx <= getBucket(box.x1 - 1); ++bx) {
+                    for(auto by = getBucket(box.y0); by <= getBucket(box.y1 - 1); ++by) {
+                        fun(getKey(bx, by));
+                    }
+                }
+            }
+
+            public:
+            void reserve(std::size_t count) {
+                m_boxes.reserve(count);
+                m_buckets.reserve(count * 2);
+            }
+
+            bool isFree(const Box& box) const {
+                bool free = true;
+                forEachBucket(box, [&](std::uint64_t key) {
+                        const auto it = m_buckets.find(key);
+                        if(free && it != m_buckets.end()) {
+                            free = std::none_of(it->second.begin(), it->second.end(), [&](SymbolId name) {
+                                    return m_boxes[name].intersects(box);
+                                    });
+                        }
+                        });
+                return free;
+            }
+
+            //Replaces the box of 'name', if it has one
+            void insert(SymbolId name, const Box& box) {
+                remove(name);
+                if(name >= m_boxes.size()) {
+                    m_boxes.resize(name + 1, Box{ 0, 0, 0, 0 });
+                }
+                m_boxes[name] = box;
+                forEachBucket(box, [&](std::uint64_t key) {
+                        m_buckets[key].emplace_back(name);
+                        });
+            }
+
+            void remove(SymbolId name) {
+                if(name >= m_boxes.size() || isEmpty(m_boxes[name])) {
+                    return;
+                }
+                forEachBucket(m_boxes[name], [&](std::uint64_t key) {
+                        auto it = m_buckets.find(key);
+                        auto& names = it->second;
+                        names.erase(std::find(names.begin(), names.end(), name));
+                        if(names.empty()) {
+                            m_buckets.erase(it);
+                        }
+                        });
+                m_boxes[name] = Box{ 0, 0, 0, 0 };
+            }
+        };
+
+        static constexpr std::int32_t m_bucketSize = 16;
+        static constexpr std::int32_t m_spacing = 1;
+        static constexpr std::int32_t m_portPitch = 2;
+        static constexpr std::int32_t m_maxRings = 16;
+
+        TCircuitGraph& m_circuit;
+        SpatialHash m_occupied;
+
+        //Where the next component attached to a connection is tried first
+        std::vector<GridPosition> m_netPoints;
+        std::vector<bool> m_hasNetPoint;
+
+        //Components not fitting anywhere near their connection go to rows below everything placed
+        std::int32_t m_bottom;
+        std::int32_t m_rowWidth;
+        GridPosition m_overflow;
+
+        //Subcircuit instances have their ports along one edge, m_portPitch apart,
+        //and the box is centered on the reference port, so it spans the edge twice
+        Footprint getFootprint(const Component& comp) const {
+            const auto type = m_circuit.getName(comp.getType());
+            switch(type.empty() ? ' ' : ::toupper(static_cast<unsigned char>(type.front()))) {
+                case 'R':
+                    return { 7, 4 };
+                case 'C':
+                    return { 4, 6 };
+                case 'X':
+                    return { 6, std::max<std::int32_t>(1, static_cast<std::int32_t>(comp.getTerminals().size())) * m_portPitch * 2 - m_portPitch };
+                default:
+                    return { 8, 8 };
+            }
+        }
+
+        //Unit vector from the reference terminal into the body
+        static GridPosition getBodyVector(D direction) {
+            switch(direction) {
+                case D::Up:
+                    return { 0, 1 };
+                case D::Down:
+                    return { 0, -1 };
+                case D::Right:
+                    return { -1, 0 };
+                default:
+                    return { 1, 0 };
+            }
+        }
+
+        static Box getBox(const GridPosition& anchor, D direction, const Footprint& fp) {
+            const auto body = getBodyVector(direction);
+            const auto half = (fp.width + 1) / 2 + m_spacing;
+            const auto farX = anchor.x + body.x * fp.length;
+            const auto farY = anchor.y + body.y * fp.length;
+            if(body.x == 0) {
+                return { anchor.x - half, std::min(anchor.y, farY) - m_spacing, anchor.x + half, std::max(anchor.y, farY) + m_spacing };
+            }
+            return { std::min(anchor.x, farX) - m_spacing, anchor.y - half, std::max(anchor.x, farX) + m_spacing, anchor.y + half };
+        }
+
+        //Rings of candidate positions around 'desired', stepping by the box size.
+        //Positions beside the desired one come first, so components sharing a
+        //connection line up along it, then those further along the body.
+        bool findFree(const GridPosition& desired, D direction, const Footprint& fp, GridPosition& anchor) const {
+            const auto body = getBodyVector(direction);
+            const GridPosition across{ body.y, body.x };
+            const auto alongStep = fp.length + 2 * m_spacing;
+            const auto acrossStep = 2 * ((fp.width + 1) / 2 + m_spacing);
+
+            auto tryAt = [&](std::int32_t along, std::int32_t acr) {
+                anchor = { desired.x + body.x * along * alongStep + across.x * acr * acrossStep,
+                           desired.y + body.y * along * alongStep + across.y * acr * acrossStep };
+                return m_occupied.isFree(getBox(anchor, direction, fp));
+            };
+
+            if(tryAt(0, 0)) {
+                return true;
+            }
+            for(std::int32_t ring = 1; ring <= m_maxRings; ++ring) {
+                for(std::int32_t step = 0; step <= 2 * ring; ++step) {
+                    //along: 0, 1, ..., ring, -1, ..., -ring
+                    const auto along = (step <= ring) ? step : ring - step;
+                    if(along == ring || along == -ring) {
+                        for(std::int32_t acr = 0; acr <= ring; ++acr) {
+                            if(tryAt(along, acr) || (acr != 0 && tryAt(along, -acr))) {
+                                return true;
+                            }
+                        }
+                    } else if(tryAt(along, ring) || tryAt(along, -ring)) {
+                        return true;
+                    }
+                }
+            }
+            return false;
+        }
+
+        //Next position of the overflow row, a new row starts below everything placed
+        //when the current one is full or was run into by components placed meanwhile
+        GridPosition getOverflowPosition(D direction, const Footprint& fp) {
+            const auto box = getBox(GridPosition{ 0, 0 }, direction, fp);
+            auto getAnchor = [&]() {
+                return GridPosition{ m_overflow.x - box.x0, m_overflow.y - box.y0 };
+            };
+
+            if(m_overflow.x > m_rowWidth || !m_occupied.isFree(getBox(getAnchor(), direction, fp))) {
+                m_overflow = { 0, m_bottom };
+            }
+            const auto anchor = getAnchor();
+            m_overflow.x += box.x1 - box.x0;
+            return anchor;
+        }
+
+        //Takes the box of 'compId' at 'anchor' and records where its connections continue
+        void occupy(ComponentId compId, const GridPosition& anchor) {
+            const auto& comp = m_circuit.getComponents()[compId];
+            const auto& recomm = comp.getRecommendation();
+            const auto direction = recomm.getDirection();
+            const auto fp = getFootprint(comp);
+
+            const auto box = getBox(anchor, direction, fp);
+            m_occupied.insert(comp.getName(), box);
+            m_bottom = std::max(m_bottom, box.y1);
+            m_circuit.setPosition(compId, anchor);
+
+            //The reference connection continues next to this component, the others at its far end
+            const auto body = getBodyVector(direction);
+            const GridPosition far{ anchor.x + body.x * fp.length, anchor.y + body.y * fp.length };
+            const auto terminals = m_circuit.getView().getTerminals(compId);
+            const auto refIdx = recomm.getReferenceTerminalIndex();
+            for(std::uint32_t t = 0; t < terminals.size(); ++t) {
+                const auto connId = terminals[t];
+                if(t == refIdx) {
+                    m_netPoints[connId] = anchor;
+                    m_hasNetPoint[connId] = true;
+                } else if(!m_hasNetPoint[connId]) {
+                    m_netPoints[connId] = far;
+                    m_hasNetPoint[connId] = true;
+                }
+            }
+        }
+
+        void place(ComponentId compId, const GridPosition& desired) {
+            const auto& comp = m_circuit.getComponents()[compId];
+            const auto direction = comp.getRecommendation().getDirection();
+            const auto fp = getFootprint(comp);
+
+            GridPosition anchor;
+            if(!findFree(desired, direction, fp, anchor)) {
+                anchor = getOverflowPosition(direction, fp);
+            }
+            occupy(compId, anchor);
+        }
+
+        //Places the components reachable from 'queue' without crossing connections already queued
+        void placeReachable(std::deque<ConnectionId>& queue, std::vector<bool>& queued, std::vector<bool>& placed) {
+            const auto& view = m_circuit.getView();
+            while(!queue.empty()) {
+                const auto connId = queue.front();
+                queue.pop_front();
+
+                for(const auto& pin : view.getPins(connId)) {
+                    if(placed[pin.component]) {
+                        continue;
+                    }
+                    placed[pin.component] = true;
+
+                    const auto& recomm = m_circuit.getComponents()[pin.component].getRecommendation();
+                    const auto refIdx = recomm.getReferenceTerminalIndex();
+                    const auto terminals = view.getTerminals(pin.component);
+                    const auto refConn = (refIdx < terminals.size()) ? terminals[refIdx] : connId;
+                    place(pin.component, m_hasNetPoint[refConn] ? m_netPoints[refConn] : m_netPoints[connId]);
+
+                    for(const auto termConn : terminals) {
+                        if(!queued[termConn]) {
+                            queued[termConn] = true;
+                            queue.emplace_back(termConn);
+                        }
+                    }
+                }
+            }
+        }
+
+        //Side of a square fitting all components, the circuit terminals are put on its edges
+        std::int32_t getSide() const {
+            double area = 0;
+            for(const auto& comp : m_circuit.getComponents()) {
+                const auto fp = getFootprint(comp);
+                area += double(fp.length + 2 * m_spacing) * double(fp.width + 2 * m_spacing);
+            }
+            return static_cast<std::int32_t>(std::ceil(std::sqrt(area) * 1.5));
+        }
+
+        void reset() {
+            const auto connectionsCount = m_circuit.getConnections().size();
+            m_netPoints.assign(connectionsCount, GridPosition{ 0, 0 });
+            m_hasNetPoint.assign(connectionsCount, false);
+            m_occupied = SpatialHash();
+            m_occupied.reserve(m_circuit.getSymbolsCount());
+
+            const auto side = getSide();
+            m_bottom = side;
+            m_rowWidth = side;
+            m_overflow = { 0, side };
+        }
+
+        //Net points of the circuit terminals, in the order their connections are to be visited
+        std::vector<ConnectionId> seedTerminals() {
+            const auto side = m_rowWidth;
+            auto terminals = m_circuit.getTerminalConnections();
+            std::stable_sort(terminals.begin(), terminals.end(), [](const auto& a, const auto& b) {
+                    return a.second > b.second;
+                    });
+
+            std::vector<ConnectionId> seeds;
+            for(const auto& term : terminals) {
+                GridPosition point{ side / 2, side / 2 };
+                switch(term.second.getDirection()) {
+                    case D::Up:
+                        point.y = 0;
+                        break;
+                    case D::Down:
+                        point.y = side;
+                        break;
+                    case D::Left:
+                        point.x = 0;
+                        break;
+                    case D::Right:
+                        point.x = side;
+                        break;
+                    default:
+                        break;
+                }
+                m_netPoints[term.first] = point;
+                m_hasNetPoint[term.first] = true;
+                seeds.emplace_back(term.first);
+            }
+            return seeds;
+        }
+
+        //Starts the island of 'compId' in the overflow rows. Returns the connection
+        //to grow it from, g_invalidId if the component has no terminals and is placed already.
+        ConnectionId seedIsland(ComponentId compId) {
+            const auto& comp = m_circuit.getComponents()[compId];
+            const auto direction = comp.getRecommendation().getDirection();
+            const auto terminals = m_circuit.getView().getTerminals(compId);
+            if(terminals.size() == 0) {
+                place(compId, getOverflowPosition(direction, getFootprint(comp)));
+                return g_invalidId;
+            }
+
+            const auto seed = terminals[0];
+            m_netPoints[seed] = getOverflowPosition(direction, getFootprint(comp));
+            m_hasNetPoint[seed] = true;
+            return seed;
+        }
+
+        //Components not reached from the seeds, island by island below the rest
+        void placeIslands(std::deque<ConnectionId>& queue, std::vector<bool>& queued, std::vector<bool>& placed) {
+            for(ComponentId compId = 0; compId < placed.size(); ++compId) {
+                if(placed[compId]) {
+                    continue;
+                }
+                const auto seed = seedIsland(compId);
+                if(seed == g_invalidId) {
+                    placed[compId] = true;
+                    continue;
+                }
+                queued[seed] = true;
+                queue.emplace_back(seed);
+                placeReachable(queue, queued, placed);
+            }
+        }
+
+        public:
+        Placement(TCircuitGraph& circuit)
+            : m_circuit(circuit), m_bottom(0), m_rowWidth(0), m_overflow{ 0, 0 } {
+        }
+
+        virtual ~Placement() = default;
+
+        //Sets the position of every component. Has to be called on a frozen circuit.
+        void run() {
+            reset();
+            std::vector<bool> queued(m_circuit.getConnections().size(), false);
+            std::vector<bool> placed(m_circuit.getComponents().size(), false);
+            std::deque<ConnectionId> queue;
+            for(const auto connId : seedTerminals()) {
+                queued[connId] = true;
+                queue.emplace_back(connId);
+            }
+            placeReachable(queue, queued, placed);
+            placeIslands(queue, queued, placed);
+        }
+
+        //Takes the positions the components have as placed, so update() can
+        //follow modifications of the circuit. Has to be called on a frozen circuit.
+        void restore() {
+            reset();
+            seedTerminals();
+            const auto& components = m_circuit.getComponents();
+            for(ComponentId compId = 0; compId < components.size(); ++compId) {
+                occupy(compId, components[compId].getPosition());
+            }
+            m_overflow = { 0, m_bottom };
+        }
+
+        //Places 'changed' (current ids) again and frees the space of 'removed' (names),
+        //every other component keeps its position and the space it takes. Changed
+        //components grow from the connections they share with the others, the way
+        //run() grows from the circuit terminals. Cost depends on the modified
+        //components only, not on the circuit or on the connections they share with it.
+        //Has to be called on the frozen circuit last placed by run(), restore() or update().
+        void update(const std::vector<ComponentId>& changed, const std::vector<SymbolId>& removed) {
+            const auto& components = m_circuit.getComponents();
+            const auto& view = m_circuit.getView();
+            const auto connectionsCount = m_circuit.getConnections().size();
+            m_netPoints.resize(connectionsCount, GridPosition{ 0, 0 });
+            m_hasNetPoint.resize(connectionsCount, false);
+
+            for(const auto name : removed) {
+                m_occupied.remove(name);
+            }
+            for(const auto compId : changed) {
+                m_occupied.remove(components[compId].getName());
+            }
+            m_overflow = { 0, m_bottom };
+
+            //Changed components attached to every connection of theirs, as indices into 'changed'
+            std::unordered_map<ConnectionId, std::vector<std::uint32_t>> pins;
+            for(std::uint32_t idx = 0; idx < changed.size(); ++idx) {
+                for(const auto connId : view.getTerminals(changed[idx])) {
+                    auto& attached = pins[connId];
+                    if(attached.empty() || attached.back() != idx) {
+                        attached.emplace_back(idx);
+                    }
+                }
+            }
+
+            std::vector<bool> placed(changed.size(), false);
+            std::unordered_map<ConnectionId, bool> queued;
+            std::deque<ConnectionId> queue;
+            auto enqueue = [&](ConnectionId connId) {
+                if(!queued[connId]) {
+                    queued[connId] = true;
+                    queue.emplace_back(connId);
+                }
+            };
+            auto grow = [&]() {
+                while(!queue.empty()) {
+                    const auto connId = queue.front();
+                    queue.pop_front();
+                    for(const auto idx : pins[connId]) {
+                        if(placed[idx]) {
+                            continue;
+                        }
+                        placed[idx] = true;
+
+                        const auto compId = changed[idx];
+                        const auto refIdx = components[compId].getRecommendation().getReferenceTerminalIndex();
+                        const auto terminals = view.getTerminals(compId);
+                        const auto refConn = (refIdx < terminals.size()) ? terminals[refIdx] : connId;
+                        place(compId, m_hasNetPoint[refConn] ? m_netPoints[refConn] : m_netPoints[connId]);
+                        for(const auto termConn : terminals) {
+                            enqueue(termConn);
+                        }
+                    }
+                }
+            };
+
+            for(const auto compId : changed) {
+                for(const auto connId : view.getTerminals(compId)) {
+                    if(m_hasNetPoint[connId]) {
+                        enqueue(connId);
+                    }
+                }
+            }
+            grow();
+
+            for(std::uint32_t idx = 0; idx < changed.size(); ++idx) {
+                if(placed[idx]) {
+                    continue;
+                }
+                const auto seed = seedIsland(changed[idx]);
+                if(seed == g_invalidId) {
+                    placed[idx] = true;
+                    continue;
+                }
+                enqueue(seed);
+                grow();
+            }
+        }
+    };
+}
+
+#endif
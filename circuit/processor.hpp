@@ -2,59 +2,194 @@
 #define PROCESSOR
 
 #include <string>
-#include <file_reader.hpp>
-#include <parser_ngspice.hpp>
-#include <gui_schematic_qt.hpp>
-#include <gui_progress_qt.hpp>
+#include <vector>
+#include <stdexcept>
+#include <pipeline.hpp>
+#include <netlist_updater.hpp>
+#include <file_watcher.hpp>
+#include <gui_schematic_interface.hpp>
+#include <gui_progress_interface.hpp>
 #include <base_thread.hpp>
+#include <logger.hpp>
 
 namespace circuit {
 
     class Processor : public task::BaseThread<const std::string,
+                                              const bool,
                                               gui::GuiSchematicInterfaceExtSync* const,
                                               gui::GuiProgressInterfaceExtSync* const> {
 
         typedef circuit::CircuitGraph<gui::GuiSchematicInterfaceExtSync,
                                       gui::GuiProgressInterfaceExtSync> TCircuitGraph;
 
+        static constexpr std::intmax_t m_watchPeriodMs = 200;
+
+        static std::vector<file_reader::FileWatcher> watchDependencies(const TCircuitGraph& circuit) {
+            std::vector<file_reader::FileWatcher> watchers;
+            for(const auto& path : circuit.getDependencies()) {
+                watchers.emplace_back(path);
+            }
+            return watchers;
+        }
+
+        static gui::SchematicItem makeItem(const TCircuitGraph& circuit, const Component& comp) {
+            const auto& connections = circuit.getConnections();
+            const auto& recomm = comp.getRecommendation();
+            const auto pos = comp.getPosition();
+            std::vector<std::string> terminals;
+            for(const auto connId : comp.getTerminals()) {
+                terminals.emplace_back(circuit.getName(connections[connId].getName()));
+            }
+            return gui::SchematicItem{ std::string(circuit.getName(comp.getType())),
+                                       std::string(circuit.getName(comp.getName())),
+                                       std::string(circuit.getName(comp.getValue())),
+                                       recomm.getName(),
+                                       recomm.getReferenceTerminal(),
+                                       pos.x,
+                                       pos.y,
+                                       std::move(terminals) };
+        }
+
+        static void updateSchematic(const TCircuitGraph& circuit,
+                                    gui::GuiSchematicInterfaceExtSync* const schIfc,
+                                    const std::vector<std::string>& level) {
+            std::vector<gui::SchematicItem> items;
+            items.reserve(circuit.getComponents().size());
+            for(const auto& comp : circuit.getComponents()) {
+                items.emplace_back(makeItem(circuit, comp));
+            }
+            schIfc->updateSchematic(std::move(items), level);
+        }
+
+        //Only what the last incremental update changed
+        static void patchSchematic(const TCircuitGraph& circuit,
+                                   const NetlistUpdater<TCircuitGraph>& updater,
+                                   gui::GuiSchematicInterfaceExtSync* const schIfc) {
+            std::vector<gui::SchematicItem> changed;
+            changed.reserve(updater.getChanged().size());
+            for(const auto compId : updater.getChanged()) {
+                changed.emplace_back(makeItem(circuit, circuit.getComponents()[compId]));
+            }
+            std::vector<std::string> removed;
+            removed.reserve(updater.getRemoved().size());
+            for(const auto name : updater.getRemoved()) {
+                removed.emplace_back(circuit.getName(name));
+            }
+            schIfc->patchSchematic(std::move(changed), std::move(removed));
+        }
+
+        //Circuit of the subcircuit instances named in 'level', one level inside the
+        //other, expanded and laid out. Throws if a name is no instance of a known subcircuit.
+        static TCircuitGraph& expandLevel(TCircuitGraph& circuit, const std::vector<std::string>& level) {
+            auto* shown = &circuit;
+            for(const auto& name : level) {
+                const auto compId = shown->findComponent(name);
+                auto* const child = (compId == g_invalidId) ? nullptr : shown->expand(compId);
+                if(child == nullptr) {
+                    throw std::runtime_error(std::string("No subcircuit instance '") + name + std::string("'"));
+                }
+                shown = child;
+            }
+            if(shown != &circuit) {
+                processSubcircuit(*shown);
+            }
+            return *shown;
+        }
+
+        //Shows the levels asked for by the user until the thread is stopped, woken
+        //by wake() on every request. With 'watch' the netlist file is polled as well,
+        //its modifications are applied and published as deltas while the netlist
+        //itself is shown. Modified included files make the netlist processed from
+        //scratch, which shows the netlist again.
+        void serveNetlist(const std::string& filename,
+                          const bool watch,
+                          file_reader::FileWatcher& watcher,
+                          TCircuitGraph& circuit,
+                          gui::GuiSchematicInterfaceExtSync* const schIfc,
+                          gui::GuiProgressInterfaceExtSync* const progressIfc) {
+            NetlistUpdater<TCircuitGraph> updater(filename);
+            std::vector<file_reader::FileWatcher> dependencies;
+            if(watch) {
+                updater.reset(circuit);
+                dependencies = watchDependencies(circuit);
+            }
+            std::vector<std::string> level;
+
+            while(isRunning()) {
+                msWait(watch ? m_watchPeriodMs : -1);
+                std::vector<std::string> requested;
+                if(schIfc->takeLevelRequest(requested)) {
+                    try {
+                        const auto& shown = expandLevel(circuit, requested);
+                        level = std::move(requested);
+                        updateSchematic(shown, schIfc, level);
+                    } catch(const std::exception& e) {
+                        logging::error("\033[0;31mSubcircuit not shown:\n", e.what(), "\033[0m");
+                    }
+                }
+                if(!watch) {
+                    continue;
+                }
+
+                bool changed = watcher.hasChanged();
+                for(auto& dependency : dependencies) {
+                    if(dependency.hasChanged()) {
+                        updater.invalidate();
+                        changed = true;
+                    }
+                }
+                if(!changed) {
+                    continue;
+                }
+
+                try {
+                    const auto result = updater.update(circuit, progressIfc);
+                    if(result == NetlistUpdater<TCircuitGraph>::Result::Full) {
+                        dependencies = watchDependencies(circuit);
+                        //Expanded circuits are gone with the previous content
+                        level.clear();
+                        updateSchematic(circuit, schIfc, level);
+                    } else if(result == NetlistUpdater<TCircuitGraph>::Result::Incremental && level.empty()) {
+                        patchSchematic(circuit, updater, schIfc);
+                    }
+                } catch(const std::exception& e) {
+                    logging::error("\033[0;31mNetlist update failed:\n", e.what(), "\033[0m");
+                }
+                logging::flush();
+            }
+        }
+
         void run(const std::string filename,
+                 const bool watch,
                  gui::GuiSchematicInterfaceExtSync* const schIfc,
                  gui::GuiProgressInterfaceExtSync* const progressIfc) override {
 
             try {
                 TCircuitGraph circuit(schIfc, progressIfc);
 
-                progressIfc->show();
+                //Created first, so edits made while processing are not missed
+                file_reader::FileWatcher watcher(filename);
 
-                parsers::ParserNGSPICE<TCircuitGraph> parser(circuit);
-                file_reader::FileReader<parsers::ParserInterface, gui::GuiProgressInterfaceExtSync> freader(&parser, progressIfc);
-                freader.readFile(filename);
+                progressIfc->show();
 
-                circuit.setTerminals( { "vdd", "vss", "gen", "out" } );
+                processNetlist(filename, circuit, progressIfc);
 
-                circuit.createRecomendations();
                 circuit.print();
                 circuit.printRecommendations();
 
+                progressIfc->hide();
 
-                //temporary progress bar test
-                progressIfc->updateLabel("Max = 55 ...");
-                progressIfc->updateMax(55);
-                for(std::int32_t i = 0; i <= 55; ++i) {
-                    progressIfc->updateProgress(i);
-                    msSleep(20);
-                }
-                //
+                updateSchematic(circuit, schIfc, {});
 
-                progressIfc->hide();
+                logging::flush();
+                serveNetlist(filename, watch && filename != "-", watcher, circuit, schIfc, progressIfc);
             } catch(const std::exception& e) {
-                std::cerr << "\033[0;31mException raised:" << std::endl;
-                std::cerr << e.what() << "\033[0m" << std::endl;
+                logging::error("\033[0;31mException raised:\n", e.what(), "\033[0m");
             } catch(...) {
-                std::cerr << "\033[0;31mUnknown exception! Something really bad happened\033[0m"
-                    << std::endl;
+                logging::error("\033[0;31mUnknown exception! Something really bad happened\033[0m");
             }
- 
+
+            logging::flush();
         }
 
         public:
@@ -0,0 +1,58 @@
+#ifndef SCRATCH_ARRAY
+#define SCRATCH_ARRAY
+
+#include <vector>
+#include <cstdint>
+
+namespace circuit {
+
+    //Values per object id, kept by a traversal. clear() starts the next one in
+    //O(1): entries not written since read as the default value, so a traversal
+    //of a few objects costs as much, however many objects the circuit has.
+    template<typename T>
+    class ScratchArray {
+        struct Entry {
+            std::uint32_t generation;
+            T value;
+        };
+
+        std::vector<Entry> m_entries;
+        std::uint32_t m_generation;
+        T m_default;
+
+        public:
+        ScratchArray(const T& defaultValue = T())
+            : m_generation(0), m_default(defaultValue) {}
+
+        virtual ~ScratchArray() = default;
+
+        //Ids below 'size' are valid until the next clear()
+        void clear(std::size_t size) {
+            if(m_entries.size() < size) {
+                m_entries.resize(size, Entry{ 0, m_default });
+            }
+            if(++m_generation == 0) {
+                for(auto& entry : m_entries) {
+                    entry.generation = 0;
+                }
+                m_generation = 1;
+            }
+        }
+
+        const T& get(std::size_t id) const {
+            const auto& entry = m_entries[id];
+            return (entry.generation == m_generation) ? entry.value : m_default;
+        }
+
+        T& operator[](std::size_t id) {
+            auto& entry = m_entries[id];
+            if(entry.generation != m_generation) {
+                entry.generation = m_generation;
+                entry.value = m_default;
+            }
+            return entry.value;
+        }
+    };
+}
+
+#endif
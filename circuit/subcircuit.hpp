@@ -0,0 +1,161 @@
+#ifndef SUBCIRCUIT
+#define SUBCIRCUIT
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <stdexcept>
+
+namespace circuit {
+
+    //Body of a .subckt definition, stored once however many instances refer to it.
+    //Lines are kept as runs of tokens in one character buffer: the first line is
+    //the header (name, ports...), every further one a component (name, nodes..., value).
+    class SubcircuitDefinition {
+        std::string m_chars;
+
+        //End offsets of tokens in m_chars and of lines in m_tokenEnds
+        std::vector<std::uint32_t> m_tokenEnds;
+        std::vector<std::uint32_t> m_lineEnds;
+
+        std::string_view getToken(std::size_t idx) const {
+            const auto begin = (idx == 0) ? 0 : m_tokenEnds[idx - 1];
+            return std::string_view(m_chars).substr(begin, m_tokenEnds[idx] - begin);
+        }
+
+        template<typename TIterator>
+        void addLine(TIterator begin, TIterator end) {
+            for(auto it = begin; it != end; ++it) {
+                m_chars.append(it->data(), it->size());
+                m_tokenEnds.emplace_back(static_cast<std::uint32_t>(m_chars.size()));
+            }
+            m_lineEnds.emplace_back(static_cast<std::uint32_t>(m_tokenEnds.size()));
+        }
+
+        SubcircuitDefinition() = default;
+
+        public:
+        SubcircuitDefinition(std::string_view name, const std::vector<std::string_view>& ports) {
+            std::vector<std::string_view> header(1, name);
+            header.insert(header.end(), ports.begin(), ports.end());
+            addLine(header.begin(), header.end());
+        }
+
+        virtual ~SubcircuitDefinition() = default;
+
+        //Recreates a definition from the arrays returned by getChars(), getTokenEnds() and getLineEnds()
+        static std::shared_ptr<const SubcircuitDefinition> restore(std::string_view chars,
+                                                                   const std::uint32_t* tokenEnds, std::size_t tokensCount,
+                                                                   const std::uint32_t* lineEnds, std::size_t linesCount) {
+            if(linesCount == 0 || lineEnds[0] == 0 || lineEnds[linesCount - 1] != tokensCount ||
+                    (tokensCount > 0 && tokenEnds[tokensCount - 1] != chars.size()) ||
+                    !std::is_sorted(tokenEnds, tokenEnds + tokensCount) ||
+                    !std::is_sorted(lineEnds, lineEnds + linesCount)) {
+                throw std::runtime_error("Invalid subcircuit definition");
+            }
+
+            auto def = std::shared_ptr<SubcircuitDefinition>(new SubcircuitDefinition());
+            def->m_chars.assign(chars);
+            def->m_tokenEnds.assign(tokenEnds, tokenEnds + tokensCount);
+            def->m_lineEnds.assign(lineEnds, lineEnds + linesCount);
+            return def;
+        }
+
+        //'tokens' as in the netlist line: name, nodes..., value
+        void addComponent(const std::string_view* tokens, std::size_t count) {
+            addLine(tokens, tokens + count);
+        }
+
+        std::string_view getName() const {
+            return getToken(0);
+        }
+
+        std::vector<std::string_view> getPorts() const {
+            std::vector<std::string_view> ports;
+            for(std::uint32_t idx = 1; idx < m_lineEnds[0]; ++idx) {
+                ports.emplace_back(getToken(idx));
+            }
+            return ports;
+        }
+
+        std::size_t getComponentsCount() const {
+            return m_lineEnds.size() - 1;
+        }
+
+        //Calls fun(tokens) for every component line, in definition order
+        template<typename TFun>
+        void forEachComponent(TFun&& fun) const {
+            std::vector<std::string_view> tokens;
+            for(std::size_t line = 1; line < m_lineEnds.size(); ++line) {
+                tokens.clear();
+                for(auto idx = m_lineEnds[line - 1]; idx < m_lineEnds[line]; ++idx) {
+                    tokens.emplace_back(getToken(idx));
+                }
+                fun(static_cast<const std::vector<std::string_view>&>(tokens));
+            }
+        }
+
+        std::string_view getChars() const {
+            return m_chars;
+        }
+
+        const std::vector<std::uint32_t>& getTokenEnds() const {
+            return m_tokenEnds;
+        }
+
+        const std::vector<std::uint32_t>& getLineEnds() const {
+            return m_lineEnds;
+        }
+    };
+
+
+    //Subcircuit definitions by name, names are case insensitive as in NGSPICE.
+    //Shared by a circuit and the circuits expanded from its instances.
+    class SubcircuitTable {
+        std::vector<std::shared_ptr<const SubcircuitDefinition>> m_definitions;
+        std::unordered_map<std::string, std::size_t> m_index;
+
+        static std::string getKey(std::string_view name) {
+            std::string key(name);
+            std::transform(key.begin(), key.end(), key.begin(), [](unsigned char c) {
+                    return static_cast<char>(::tolower(c));
+                    });
+            return key;
+        }
+
+        public:
+        SubcircuitTable() = default;
+        virtual ~SubcircuitTable() = default;
+
+        //Returns false, keeping the first definition, when the name is taken
+        bool add(std::shared_ptr<const SubcircuitDefinition> def) {
+            if(!m_index.emplace(getKey(def->getName()), m_definitions.size()).second) {
+                return false;
+            }
+            m_definitions.emplace_back(std::move(def));
+            return true;
+        }
+
+        const SubcircuitDefinition* find(std::string_view name) const {
+            const auto it = m_index.find(getKey(name));
+            return (it == m_index.end()) ? nullptr : m_definitions[it->second].get();
+        }
+
+        //In order of definition
+        const std::vector<std::shared_ptr<const SubcircuitDefinition>>& getDefinitions() const {
+            return m_definitions;
+        }
+
+        void clear() {
+            m_definitions.clear();
+            m_index.clear();
+        }
+    };
+}
+
+#endif
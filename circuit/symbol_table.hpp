@@ -0,0 +1,124 @@
+#ifndef SYMBOL_TABLE
+#define SYMBOL_TABLE
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory_resource>
+#include <functional>
+#include <algorithm>
+#include <limits>
+#include <cstring>
+#include <cstdint>
+#include <stdexcept>
+
+namespace circuit {
+
+    typedef std::uint32_t SymbolId;
+
+    constexpr SymbolId g_invalidId = std::numeric_limits<std::uint32_t>::max();
+
+    //Interns names into dense 32-bit ids. Every distinct name is stored once,
+    //ids are assigned in order of first appearance. Characters of all names
+    //live in a monotonic arena, the index is an open addressing hash table of
+    //ids, so interning a new name costs no allocation of its own.
+    class SymbolTable {
+        static constexpr std::size_t m_arenaBlock = 64 * 1024;
+        static constexpr std::size_t m_minSlots = 64;
+
+        std::pmr::monotonic_buffer_resource m_arena;
+        std::vector<std::string_view> m_names;
+
+        //Power of two sized, at most half full, g_invalidId marks free slots
+        std::vector<SymbolId> m_slots;
+
+        SymbolTable(const SymbolTable&) = delete;
+        SymbolTable& operator=(const SymbolTable&) = delete;
+
+        static std::size_t hash(std::string_view name) {
+            return std::hash<std::string_view>()(name);
+        }
+
+        std::size_t findSlot(std::string_view name) const {
+            const auto mask = m_slots.size() - 1;
+            auto slot = hash(name) & mask;
+            while(m_slots[slot] != g_invalidId && m_names[m_slots[slot]] != name) {
+                slot = (slot + 1) & mask;
+            }
+            return slot;
+        }
+
+        void rehash(std::size_t count) {
+            std::size_t size = m_minSlots;
+            while(size < 2 * count) {
+                size *= 2;
+            }
+            if(size <= m_slots.size()) {
+                return;
+            }
+
+            m_slots.assign(size, g_invalidId);
+            for(SymbolId id = 0; id < m_names.size(); ++id) {
+                m_slots[findSlot(m_names[id])] = id;
+            }
+        }
+
+        public:
+        SymbolTable()
+            : m_arena(m_arenaBlock), m_slots(m_minSlots, g_invalidId) {}
+
+        virtual ~SymbolTable() = default;
+
+        SymbolId intern(std::string_view name) {
+            auto slot = findSlot(name);
+            if(m_slots[slot] != g_invalidId) {
+                return m_slots[slot];
+            }
+
+            if(m_names.size() >= g_invalidId - 1) {
+                throw std::runtime_error("Symbol table overflow!");
+            }
+
+            auto* const chars = static_cast<char*>(m_arena.allocate(std::max<std::size_t>(name.size(), 1), 1));
+            std::memcpy(chars, name.data(), name.size());
+
+            const auto id = static_cast<SymbolId>(m_names.size());
+            m_names.emplace_back(chars, name.size());
+            if(2 * m_names.size() > m_slots.size()) {
+                rehash(m_names.size());
+            } else {
+                m_slots[slot] = id;
+            }
+            return id;
+        }
+
+        void reserve(std::size_t count) {
+            m_names.reserve(count);
+            rehash(count);
+        }
+
+        //Releases the arena, views returned by getName() become invalid
+        void clear() {
+            m_names.clear();
+            m_slots.assign(m_minSlots, g_invalidId);
+            m_arena.release();
+        }
+
+        SymbolId find(std::string_view name) const {
+            return m_slots[findSlot(name)];
+        }
+
+        std::string_view getName(SymbolId id) const {
+            if(id >= m_names.size()) {
+                throw std::runtime_error(std::string("Symbol id '") + std::to_string(id) + std::string("' not found!"));
+            }
+            return m_names[id];
+        }
+
+        std::size_t size() const {
+            return m_names.size();
+        }
+    };
+}
+
+#endif
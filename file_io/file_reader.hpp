@@ -1,37 +1,151 @@
 #ifndef FILE_READER
 #define FILE_READER
 
+#include <iostream>
 #include <fstream>
 #include <string>
-#include <vector>
+#include <string_view>
+#include <limits>
+#include <algorithm>
+#include <deque>
+#include <future>
+#include <mapped_file.hpp>
+#include <thread_pool.hpp>
 
 namespace file_reader {
 
     template<typename TParser, typename TProgress>
     class FileReader {
 
+        static constexpr std::size_t m_chunkSize = 4 * 1024 * 1024;
+        static constexpr std::size_t m_parallelThreshold = 2 * m_chunkSize;
+        static constexpr std::size_t m_progressStep = 64 * 1024;
+
         TParser* m_parser;
         TProgress* m_progressIfc;
 
         FileReader() = delete;
 
-        void removeWindowsDelim(std::string& line) {
-            try {
-                auto last = line.length() - 1;
-                if(line.at(last) == 0x0D) {
-                    line.erase(last, 1); 
+        std::string_view removeWindowsDelim(std::string_view line) const {
+            if(!line.empty() && line.back() == 0x0D) {
+                line.remove_suffix(1);
+            }
+            return line;
+        }
+
+        //Progress is reported in bytes, scaled down by 2^shift
+        //when the file does not fit the 32-bit progress range
+        unsigned getProgressShift(std::size_t size) const {
+            unsigned shift = 0;
+            while((size >> shift) > static_cast<std::size_t>(std::numeric_limits<std::int32_t>::max())) {
+                ++shift;
+            }
+            return shift;
+        }
+
+        //Calls fun(line, nextLineOffset) for every line of 'data', line delimiters excluded
+        template<typename TFun>
+        void forEachLine(std::string_view data, TFun&& fun) const {
+            const auto size = data.size();
+            std::size_t pos = 0;
+            while(pos < size) {
+                auto end = data.find('\n', pos);
+                if(end == std::string_view::npos) {
+                    end = size;
                 }
-            } catch(const std::out_of_range& e) {
+
+                fun(removeWindowsDelim(data.substr(pos, end - pos)), end + 1);
+                pos = end + 1;
+            }
+        }
+
+        //End of the line aligned chunk starting at 'pos'
+        std::size_t findChunkEnd(std::string_view data, std::size_t pos) const {
+            if(data.size() - pos <= m_chunkSize) {
+                return data.size();
             }
+            auto end = data.find('\n', pos + m_chunkSize);
+            return (end == std::string_view::npos) ? data.size() : end + 1;
         }
 
-        std::size_t getLinesCount(std::ifstream& ifs) const {
-            auto pos = ifs.tellg();
-            ifs.seekg(0);
-            auto lines = std::count(std::istreambuf_iterator<char>(ifs),
-                    std::istreambuf_iterator<char>(), '\n');
-            ifs.seekg(pos);
-            return lines;
+        void readSerial(std::string_view data, unsigned shift) {
+            const auto size = data.size();
+            std::size_t reported = 0;
+            forEachLine(data, [&](std::string_view line, std::size_t next) {
+                    m_parser->parseLine(line);
+                    next = std::min(next, size);
+                    if(next - reported >= m_progressStep || next == size) {
+                        m_progressIfc->updateProgress(static_cast<std::int32_t>(next >> shift));
+                        reported = next;
+                    }
+                    });
+        }
+
+        //Chunks are classified on the pool and committed to the parser in
+        //input order, at most two chunks per worker are in flight
+        void readParallel(std::string_view data, unsigned shift) {
+            typedef decltype(m_parser->createChunk()) TChunk;
+
+            task::ThreadPool pool;
+            const auto window = pool.size() * 2;
+            const auto size = data.size();
+            std::deque<std::pair<std::future<TChunk>, std::size_t>> pending;
+            std::size_t pos = 0;
+
+            auto submitNext = [&]() {
+                const auto end = findChunkEnd(data, pos);
+                const auto text = data.substr(pos, end - pos);
+                auto result = pool.submit([this, text]() {
+                        auto chunk = m_parser->createChunk();
+                        forEachLine(text, [&](std::string_view line, std::size_t) {
+                                m_parser->classifyLine(line, *chunk);
+                                });
+                        return chunk;
+                        });
+                pending.emplace_back(std::move(result), end);
+                pos = end;
+            };
+
+            while(pos < size && pending.size() < window) {
+                submitNext();
+            }
+
+            while(!pending.empty()) {
+                auto chunk = pending.front().first.get();
+                const auto end = pending.front().second;
+                pending.pop_front();
+
+                m_parser->commitChunk(*chunk);
+                m_progressIfc->updateProgress(static_cast<std::int32_t>(end >> shift));
+
+                if(pos < size) {
+                    submitNext();
+                }
+            }
+        }
+
+        void readMapped(const MappedFile& file) {
+            const auto data = file.getData();
+            const auto size = data.size();
+            const auto shift = getProgressShift(size);
+            m_progressIfc->updateMax(static_cast<std::int32_t>(size >> shift));
+
+            //Inside a pool task, e.g. of a batch, the other workers are busy with their own files
+            if(size >= m_parallelThreshold && task::ThreadPool::getDefaultSize() > 1 && !task::ThreadPool::isWorkerThread()) {
+                readParallel(data, shift);
+            } else {
+                readSerial(data, shift);
+            }
+        }
+
+        void readStream(std::istream& is) {
+            //Size of the input is unknown, max = 0 shows busy indicator
+            m_progressIfc->updateMax(0);
+
+            std::string line;
+            while(std::getline(is, line)) {
+                m_parser->parseLine(removeWindowsDelim(line));
+            }
         }
 
         public:
@@ -42,18 +156,20 @@ namespace file_reader {
         virtual ~FileReader() = default;
 
         void readFile(const std::string& filename) {
+            if(filename == "-") {
+                readStream(std::cin);
+                return;
+            }
+
+            MappedFile file(filename);
+            if(file.isMapped()) {
+                readMapped(file);
+                return;
+            }
+
             std::ifstream ifs(filename);
             if(ifs.is_open()) {
-                m_progressIfc->updateLabel("Reading netlist and creating circuit graph...");
-                m_progressIfc->updateMax(getLinesCount(ifs));
-
-                std::size_t lc = 0;
-                std::string line;
-                while(std::getline(ifs, line)) {
-                    removeWindowsDelim(line);
-                    m_parser->parseLine(line);
-                    m_progressIfc->updateProgress(++lc);
-                }
+                readStream(ifs);
             } else {
                 throw std::runtime_error(std::string("File open error '") + filename + std::string("'"));
             }
@@ -0,0 +1,88 @@
+#ifndef FILE_UTILS
+#define FILE_UTILS
+
+#include <string>
+#include <string_view>
+#include <filesystem>
+#include <cstdint>
+#include <mapped_file.hpp>
+
+namespace file_reader {
+
+    //64-bit FNV-1a
+    inline std::uint64_t hashContent(std::string_view data) {
+        std::uint64_t hash = 0xcbf29ce484222325ULL;
+        for(const char c : data) {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= 0x100000001b3ULL;
+        }
+        return hash;
+    }
+
+    //Returns false if the file cannot be read (missing, not a regular file, no access)
+    inline bool hashFile(const std::string& filename, std::uint64_t& hash) {
+        std::error_code ec;
+        if(!std::filesystem::is_regular_file(filename, ec)) {
+            return false;
+        }
+
+        try {
+            MappedFile file(filename);
+            if(!file.isMapped()) {
+                return false;
+            }
+            hash = hashContent(file.getData());
+            return true;
+        } catch(const std::runtime_error& e) {
+            return false;
+        }
+    }
+
+    //Size and modification time of a file, a change of either means the file was modified
+    struct FileStamp {
+        bool exists;
+        std::uintmax_t size;
+        std::filesystem::file_time_type mtime;
+
+        bool operator==(const FileStamp& other) const {
+            return exists == other.exists && size == other.size && mtime == other.mtime;
+        }
+
+        bool operator!=(const FileStamp& other) const {
+            return !operator==(other);
+        }
+    };
+
+    inline FileStamp getFileStamp(const std::string& filename) {
+        std::error_code ecSize;
+        std::error_code ecTime;
+        const auto size = std::filesystem::file_size(filename, ecSize);
+        const auto mtime = std::filesystem::last_write_time(filename, ecTime);
+        if(ecSize || ecTime) {
+            return FileStamp{ false, 0, std::filesystem::file_time_type() };
+        }
+        return FileStamp{ true, size, mtime };
+    }
+
+    inline std::string getAbsolutePath(const std::filesystem::path& path) {
+        std::error_code ec;
+        const auto absolute = std::filesystem::absolute(path, ec);
+        return (ec ? path : absolute).lexically_normal().string();
+    }
+
+    //Absolute path of a file referenced from 'netlist' (e.g. by .include),
+    //relative paths are taken relative to the directory of the referencing netlist
+    inline std::string resolveIncludePath(const std::string& netlist, std::string_view path) {
+        if(path.size() >= 2 && (path.front() == '"' || path.front() == '\'') && path.back() == path.front()) {
+            path = path.substr(1, path.size() - 2);
+        }
+
+        std::filesystem::path include(path);
+        if(include.is_relative()) {
+            include = std::filesystem::path(netlist).parent_path() / include;
+        }
+        return getAbsolutePath(include);
+    }
+}
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef FILE_WATCHER
+#define FILE_WATCHER
+
+#include <string>
+#include <file_utils.hpp>
+
+namespace file_reader {
+
+    //Detects modifications of a file by polling its size and modification time.
+    //Editors replacing the file (write to temporary + rename) are detected as well.
+    class FileWatcher {
+        std::string m_filename;
+        FileStamp m_stamp;
+
+        public:
+        FileWatcher(const std::string& filename)
+            : m_filename(filename), m_stamp(getFileStamp(filename)) {}
+
+        virtual ~FileWatcher() = default;
+
+        //True once per modification, a missing file is never reported as changed
+        bool hasChanged() {
+            const auto stamp = getFileStamp(m_filename);
+            if(stamp == m_stamp) {
+                return false;
+            }
+            m_stamp = stamp;
+            return stamp.exists;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef MAPPED_FILE
+#define MAPPED_FILE
+
+#include <string>
+#include <string_view>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define MAPPED_FILE_POSIX
+#endif
+
+namespace file_reader {
+
+    //Read-only memory mapping of a regular file. Anything that cannot be
+    //mapped (pipes, character devices, non-POSIX platforms) is reported
+    //via isMapped() so the caller can fall back to stream reading.
+    class MappedFile {
+        const char* m_data;
+        std::size_t m_size;
+        bool m_mapped;
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        public:
+        MappedFile(const std::string& filename)
+            : m_data(nullptr), m_size(0), m_mapped(false) {
+#ifdef MAPPED_FILE_POSIX
+            struct stat st;
+            if(::stat(filename.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+                return;
+            }
+
+            int fd = ::open(filename.c_str(), O_RDONLY);
+            if(fd < 0) {
+                throw std::runtime_error(std::string("File open error '") + filename + std::string("'"));
+            }
+
+            m_size = static_cast<std::size_t>(st.st_size);
+            if(m_size > 0) {
+                void* addr = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if(addr == MAP_FAILED) {
+                    ::close(fd);
+                    m_size = 0;
+                    return;
+                }
+                ::madvise(addr, m_size, MADV_SEQUENTIAL);
+                m_data = static_cast<const char*>(addr);
+            }
+            ::close(fd);
+            m_mapped = true;
+#else
+            (void)filename;
+#endif
+        }
+
+        virtual ~MappedFile() {
+#ifdef MAPPED_FILE_POSIX
+            if(m_data != nullptr) {
+                ::munmap(const_cast<char*>(m_data), m_size);
+            }
+#endif
+        }
+
+        bool isMapped() const {
+            return m_mapped;
+        }
+
+        std::string_view getData() const {
+            return std::string_view(m_data, m_size);
+        }
+    };
+}
+
+#endif
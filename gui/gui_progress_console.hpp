@@ -0,0 +1,50 @@
+#ifndef GUI_PROGRESS_CONSOLE
+#define GUI_PROGRESS_CONSOLE
+
+#include <string>
+#include <atomic>
+#include <gui_progress_interface.hpp>
+#include <logger.hpp>
+
+namespace gui {
+
+    //Progress sink for headless processing. Progress values are only kept,
+    //labels and phase timings go to the log prefixed with the job name.
+    class GuiProgressConsole : public GuiProgressInterfaceExtSync {
+        std::string m_jobName;
+        std::atomic<std::int32_t> m_value;
+        std::atomic<std::int32_t> m_max;
+
+        public:
+        GuiProgressConsole(const std::string& jobName)
+            : m_jobName(jobName), m_value(0), m_max(0) {
+        }
+
+        virtual ~GuiProgressConsole() = default;
+
+        //External synchronized interface
+        virtual void updateProgress(std::int32_t value) override {
+            m_value.store(value, std::memory_order_relaxed);
+        }
+
+        virtual void updateMax(std::int32_t max) override {
+            m_max.store(max, std::memory_order_relaxed);
+        }
+
+        virtual void updateLabel(const std::string& label) override {
+            logging::debug("[", m_jobName, "] ", label);
+        }
+
+        virtual void reportPhase(const std::string& phase, std::chrono::milliseconds elapsed) override {
+            logging::info("[", m_jobName, "] Phase '", phase, "' finished in ", elapsed.count(), " ms");
+        }
+
+        virtual void show() const override {
+        }
+
+        virtual void hide() const override {
+        }
+    };
+}
+
+#endif
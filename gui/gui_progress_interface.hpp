@@ -2,6 +2,7 @@
 #define GUI_PROGRESS_INTERFACE
 
 #include <string>
+#include <chrono>
 
 namespace gui {
 
@@ -10,6 +11,7 @@ namespace gui {
         virtual void updateProgress(std::int32_t value) = 0;
         virtual void updateMax(std::int32_t max) = 0;
         virtual void updateLabel(const std::string& label) = 0;
+        virtual void reportPhase(const std::string& phase, std::chrono::milliseconds elapsed) = 0;
         virtual void show() const = 0;
         virtual void hide() const = 0;
     };
@@ -0,0 +1,65 @@
+#ifndef GUI_PROGRESS_PHASE
+#define GUI_PROGRESS_PHASE
+
+#include <string>
+#include <chrono>
+#include <exception>
+#include <gui_progress_interface.hpp>
+
+namespace gui {
+
+    //Scoped processing phase. Announces itself on the progress interface when
+    //created and reports its measured duration when finished or destroyed,
+    //unless it is destroyed by an exception.
+    class ProgressPhase {
+        GuiProgressInterfaceExtSync* m_progressIfc;
+        std::string m_name;
+        std::int32_t m_max;
+        std::chrono::steady_clock::time_point m_start;
+        int m_uncaughtExceptions;
+        bool m_finished;
+
+        ProgressPhase(const ProgressPhase&) = delete;
+        ProgressPhase& operator=(const ProgressPhase&) = delete;
+
+        public:
+        //max = 0 means the phase reports no intermediate progress
+        ProgressPhase(GuiProgressInterfaceExtSync* const progressIfc, const std::string& name, std::int32_t max = 0)
+            : m_progressIfc(progressIfc),
+            m_name(name),
+            m_max(max),
+            m_uncaughtExceptions(std::uncaught_exceptions()),
+            m_finished(false) {
+            m_progressIfc->updateLabel(m_name + "...");
+            m_progressIfc->updateMax(m_max);
+            m_progressIfc->updateProgress(0);
+            m_start = std::chrono::steady_clock::now();
+        }
+
+        virtual ~ProgressPhase() {
+            if(std::uncaught_exceptions() != m_uncaughtExceptions) {
+                return;
+            }
+
+            try {
+                finish();
+            } catch(...) {
+            }
+        }
+
+        void finish() {
+            if(m_finished) {
+                return;
+            }
+            m_finished = true;
+
+            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - m_start);
+            if(m_max > 0) {
+                m_progressIfc->updateProgress(m_max);
+            }
+            m_progressIfc->reportPhase(m_name, elapsed);
+        }
+    };
+}
+
+#endif
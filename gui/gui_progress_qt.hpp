@@ -3,9 +3,13 @@
 
 #include <iostream>
 #include <memory>
-#include <mutex>
+#include <atomic>
+#include <array>
+#include <thread>
+#include <algorithm>
 #include <progress.h>
 #include <gui_progress_interface.hpp>
+#include <logger.hpp>
 
 namespace gui {
 
@@ -14,26 +18,27 @@ namespace gui {
                           public GuiProgressInterfaceInt {
         std::unique_ptr<gui_qt::Progress> m_progress;
 
-        std::mutex m_mtx;
-        std::int32_t m_sharedValue;
-        std::int32_t m_sharedMax;
-        std::string m_sharedLabel;
-
-        //use returned reference only when 'dst' is a local (not shared) object
-        template<typename T>
-        T& safeCopy(T& dst, const T& src) {
-            std::unique_lock<std::mutex> lck(m_mtx);
-            dst = src;
-            return dst;
-        }
+        //Longer labels are cut
+        static constexpr std::size_t m_maxLabelSize = 128;
 
-        void notifyProgress() const {
-            emit m_progress->signalNewData();
-        }
+        //Written by the processing thread, polled by the dialog at a fixed rate.
+        //Nothing here signals the GUI thread or takes a lock.
+        std::atomic<std::int32_t> m_sharedValue;
+        std::atomic<std::int32_t> m_sharedMax;
+
+        //Label under a sequence counter, odd while the processing thread rewrites it.
+        //The reader copies it and starts over if the counter changed meanwhile.
+        std::atomic<std::uint32_t> m_labelSeq;
+        std::atomic<std::uint32_t> m_labelSize;
+        std::array<std::atomic<char>, m_maxLabelSize> m_labelChars;
 
         public:
         GuiProgressQt()
-            : m_progress(new gui_qt::Progress(this)) {
+            : m_progress(new gui_qt::Progress(this)),
+            m_sharedValue(0),
+            m_sharedMax(0),
+            m_labelSeq(0),
+            m_labelSize(0) {
         }
 
         virtual ~GuiProgressQt() = default;
@@ -41,18 +46,28 @@ namespace gui {
 
         //External synchronized interface
         virtual void updateProgress(std::int32_t value) override {
-            safeCopy(m_sharedValue, value);
-            notifyProgress();
+            m_sharedValue.store(value, std::memory_order_relaxed);
         }
 
         virtual void updateMax(std::int32_t max) override {
-            safeCopy(m_sharedMax, max);
-            notifyProgress();
+            m_sharedMax.store(max, std::memory_order_relaxed);
         }
 
+        //Single writer, labels come from the processing thread only
         virtual void updateLabel(const std::string& label) override {
-            safeCopy(m_sharedLabel, label);
-            notifyProgress();
+            const auto size = std::min(label.size(), m_labelChars.size());
+            const auto seq = m_labelSeq.load(std::memory_order_relaxed);
+            m_labelSeq.store(seq + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            for(std::size_t i = 0; i < size; ++i) {
+                m_labelChars[i].store(label[i], std::memory_order_relaxed);
+            }
+            m_labelSize.store(static_cast<std::uint32_t>(size), std::memory_order_relaxed);
+            m_labelSeq.store(seq + 2, std::memory_order_release);
+        }
+
+        virtual void reportPhase(const std::string& phase, std::chrono::milliseconds elapsed) override {
+            logging::info("Phase '", phase, "' finished in ", elapsed.count(), " ms");
         }
 
         virtual void show() const override {
@@ -66,18 +81,30 @@ namespace gui {
 
         //Internal interface
         virtual std::int32_t getValue() override {
-            std::int32_t val;
-            return safeCopy(val, m_sharedValue);
+            return m_sharedValue.load(std::memory_order_relaxed);
         }
 
         virtual std::int32_t getMax() override {
-            std::int32_t max;
-            return safeCopy(max, m_sharedMax);
+            return m_sharedMax.load(std::memory_order_relaxed);
         }
 
         virtual std::string getLabel() override {
-            std::string lab;
-            return safeCopy(lab, m_sharedLabel);
+            std::string label;
+            while(true) {
+                const auto seq = m_labelSeq.load(std::memory_order_acquire);
+                if(seq & 1) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                label.resize(std::min<std::size_t>(m_labelSize.load(std::memory_order_relaxed), m_labelChars.size()));
+                for(std::size_t i = 0; i < label.size(); ++i) {
+                    label[i] = m_labelChars[i].load(std::memory_order_relaxed);
+                }
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if(m_labelSeq.load(std::memory_order_relaxed) == seq) {
+                    return label;
+                }
+            }
         }
 
     };
@@ -1,18 +1,68 @@
 #ifndef GUI_SCHEMATIC_INTERFACE
 #define GUI_SCHEMATIC_INTERFACE
 
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+
 namespace gui {
 
+    //Placed component, positioned by its reference terminal in grid units.
+    //Recommendation and reference terminal are empty for components without one.
+    //Connection 'i' is attached to terminal i + 1.
+    struct SchematicItem {
+        std::string type;
+        std::string name;
+        std::string value;
+        std::string recommendation;
+        std::string refTerminal;
+        std::int32_t x;
+        std::int32_t y;
+        std::vector<std::string> connections;
+    };
+
+    //Built by the processing thread and inserted by the GUI in one pass. A full
+    //batch holds the whole schematic, a delta batch only the components added
+    //or changed since the previous batch and the names of those removed.
+    struct SchematicBatch {
+        bool full;
+        std::vector<SchematicItem> items;
+        std::vector<std::string> removed;
+        //Names of the subcircuit instances leading to the circuit shown, empty for the netlist
+        std::vector<std::string> level;
+        std::chrono::steady_clock::time_point published;
+    };
+
     class GuiSchematicInterfaceExtSync {
         public:
+        //Replaces the schematic shown, 'items' are all components of the circuit at 'level'
+        virtual void updateSchematic(std::vector<SchematicItem> items, std::vector<std::string> level) = 0;
+
+        //Replaces or adds the components of 'changed' by name and removes those
+        //named in 'removed', the others stay as they are
+        virtual void patchSchematic(std::vector<SchematicItem> changed, std::vector<std::string> removed) = 0;
+
+        //Level the user asked to see since the previous call, returns false if none
+        virtual bool takeLevelRequest(std::vector<std::string>& level) = 0;
     };
 
     class GuiSchematicInterfaceExt {
         public:
+        //Called on the thread of requestLevel() after every request, so that the
+        //processing thread need not poll takeLevelRequest()
+        virtual void setLevelListener(std::function<void()> listener) = 0;
     };
 
     class GuiSchematicInterfaceInt {
         public:
+        //Batches published since the previous call, oldest first. Batches
+        //before the last full one are dropped, they are replaced by it.
+        virtual std::vector<SchematicBatch> takeBatches() = 0;
+
+        //Asks for the circuit at 'level' to be shown, a later request replaces an earlier one
+        virtual void requestLevel(std::vector<std::string> level) = 0;
     };
 
 }
@@ -0,0 +1,27 @@
+#ifndef GUI_SCHEMATIC_NULL
+#define GUI_SCHEMATIC_NULL
+
+#include <gui_schematic_interface.hpp>
+
+namespace gui {
+
+    //Schematic sink for headless processing, discards everything
+    class GuiSchematicNull : public GuiSchematicInterfaceExtSync {
+        public:
+        GuiSchematicNull() = default;
+        virtual ~GuiSchematicNull() = default;
+
+        //External synchronized interface
+        virtual void updateSchematic(std::vector<SchematicItem> /* items */, std::vector<std::string> /* level */) override {
+        }
+
+        virtual void patchSchematic(std::vector<SchematicItem> /* changed */, std::vector<std::string> /* removed */) override {
+        }
+
+        virtual bool takeLevelRequest(std::vector<std::string>& /* level */) override {
+            return false;
+        }
+    };
+}
+
+#endif
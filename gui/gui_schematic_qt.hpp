@@ -4,6 +4,10 @@
 #include <iostream>
 #include <memory>
 #include <mutex>
+#include <vector>
+#include <optional>
+#include <functional>
+#include <string>
 #include <schematic.h>
 #include <gui_schematic_interface.hpp>
 
@@ -14,6 +18,27 @@ namespace gui {
                            public GuiSchematicInterfaceInt {
         std::unique_ptr<gui_qt::Schematic> m_schematic;
 
+        //Published by the processing thread, taken over by the dialog on signalNewData.
+        //Deltas build on each other, so none may be skipped.
+        std::mutex m_batchesMutex;
+        std::vector<SchematicBatch> m_batches;
+
+        //Set by the dialog, taken by the processing thread
+        std::mutex m_levelMutex;
+        std::optional<std::vector<std::string>> m_levelRequest;
+        std::function<void()> m_levelListener;
+
+        void publish(SchematicBatch batch) {
+            {
+                std::lock_guard<std::mutex> lock(m_batchesMutex);
+                if(batch.full) {
+                    m_batches.clear();
+                }
+                m_batches.emplace_back(std::move(batch));
+            }
+            emit m_schematic->signalNewData();
+        }
+
         public:
         GuiSchematicQt()
             : m_schematic(new gui_qt::Schematic(this)) {
@@ -22,12 +47,51 @@ namespace gui {
         virtual ~GuiSchematicQt() = default;
 
         //External synchronized interface
+        virtual void updateSchematic(std::vector<SchematicItem> items, std::vector<std::string> level) override {
+            publish(SchematicBatch{ true, std::move(items), {}, std::move(level), std::chrono::steady_clock::now() });
+        }
+
+        virtual void patchSchematic(std::vector<SchematicItem> changed, std::vector<std::string> removed) override {
+            publish(SchematicBatch{ false, std::move(changed), std::move(removed), {}, std::chrono::steady_clock::now() });
+        }
+
+        virtual bool takeLevelRequest(std::vector<std::string>& level) override {
+            std::lock_guard<std::mutex> lock(m_levelMutex);
+            if(!m_levelRequest) {
+                return false;
+            }
+            level = std::move(*m_levelRequest);
+            m_levelRequest.reset();
+            return true;
+        }
 
 
         //External interface
+        virtual void setLevelListener(std::function<void()> listener) override {
+            std::lock_guard<std::mutex> lock(m_levelMutex);
+            m_levelListener = std::move(listener);
+        }
 
 
         //Internal interface
+        virtual std::vector<SchematicBatch> takeBatches() override {
+            std::vector<SchematicBatch> batches;
+            std::lock_guard<std::mutex> lock(m_batchesMutex);
+            batches.swap(m_batches);
+            return batches;
+        }
+
+        virtual void requestLevel(std::vector<std::string> level) override {
+            std::function<void()> listener;
+            {
+                std::lock_guard<std::mutex> lock(m_levelMutex);
+                m_levelRequest = std::move(level);
+                listener = m_levelListener;
+            }
+            if(listener) {
+                listener();
+            }
+        }
 
     };
 }
@@ -0,0 +1,61 @@
+#ifndef LABEL_FONT
+#define LABEL_FONT
+
+#include <QFont>
+#include <QFontMetricsF>
+#include <QString>
+#include <array>
+#include <string>
+
+namespace gui_qt {
+
+    //Font of the component labels, looked up once per process. Advances of
+    //the ASCII glyphs are measured up front so label extents are sums of
+    //table entries. Used from the GUI thread only, after the application is created.
+    class LabelFont {
+        QFont m_font;
+        qreal m_height;
+        std::array<qreal, 128> m_advances;
+
+        LabelFont()
+            : m_font("Courier New", 8, QFont::Normal) {
+            QFontMetricsF fm(m_font);
+            m_height = fm.height();
+            for(std::size_t c = 0; c < m_advances.size(); ++c) {
+                m_advances[c] = fm.width(QChar(static_cast<ushort>(c)));
+            }
+        }
+
+        public:
+        virtual ~LabelFont() = default;
+
+        static const LabelFont& instance() {
+            static LabelFont font;
+            return font;
+        }
+
+        const QFont& getFont() const {
+            return m_font;
+        }
+
+        qreal getHeight() const {
+            return m_height;
+        }
+
+        //Kerning is not applied, which is exact for the monospaced label font
+        qreal getWidth(const std::string& text) const {
+            qreal width = 0;
+            for(auto c : text) {
+                const auto uc = static_cast<unsigned char>(c);
+                if(uc >= m_advances.size()) {
+                    return QFontMetricsF(m_font).width(QString::fromStdString(text));
+                }
+                width += m_advances[uc];
+            }
+            return width;
+        }
+    };
+
+}
+
+#endif
@@ -12,6 +12,7 @@ namespace gui_qt {
         m_layout.reset(new QFormLayout());
         m_progressBar.reset(new QProgressBar());
         m_label.reset(new QLabel());
+        m_pollTimer.reset(new QTimer());
 
         m_progressBar->setMinimumWidth(400);
         m_label->setText("");
@@ -27,27 +28,39 @@ namespace gui_qt {
         m_progressBar->setMaximum(0);
         m_progressBar->setValue(0);
 
-        connect(this, SIGNAL(signalNewData()), this, SLOT(slotNewData()));
+        m_pollTimer->setInterval(m_pollIntervalMs);
+
+        connect(m_pollTimer.get(), SIGNAL(timeout()), this, SLOT(slotNewData()));
         connect(this, SIGNAL(signalShow()), this, SLOT(slotShow()));
         connect(this, SIGNAL(signalHide()), this, SLOT(slotHide()));
     }
 
     void Progress::slotNewData() {
-        auto label = m_ifc->getLabel();
-        m_label->setText(label.c_str());
+        auto label = QString::fromStdString(m_ifc->getLabel());
+        if(label != m_label->text()) {
+            m_label->setText(label);
+        }
 
         auto val = m_ifc->getMax();
-        m_progressBar->setMaximum(val);
+        if(val != m_progressBar->maximum()) {
+            m_progressBar->setMaximum(val);
+        }
 
         val = m_ifc->getValue();
-        m_progressBar->setValue(val);
+        if(val != m_progressBar->value()) {
+            m_progressBar->setValue(val);
+        }
     }
 
     void Progress::slotShow() {
+        slotNewData();
+        m_pollTimer->start();
         show();
     }
 
     void Progress::slotHide() {
+        m_pollTimer->stop();
+        slotNewData();
         hide();
     }
 
@@ -5,6 +5,7 @@
 #include <QFormLayout>
 #include <QProgressBar>
 #include <QLabel>
+#include <QTimer>
 #include <memory>
 #include <gui_progress_interface.hpp>
 
@@ -21,13 +22,17 @@ namespace gui_qt {
 
         std::shared_ptr<QLabel> m_label;
 
+        //Progress data is polled while the dialog is visible
+        std::shared_ptr<QTimer> m_pollTimer;
+
+        static constexpr int m_pollIntervalMs = 33;
+
         public slots:
         void slotNewData();
         void slotShow();
         void slotHide();
 
         signals:
-        void signalNewData();
         void signalShow();
         void signalHide();
 
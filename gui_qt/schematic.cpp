@@ -1,11 +1,25 @@
 #include <QtWidgets>
 #include <iostream>
+#include <unordered_map>
+#include <unordered_set>
+#include <cmath>
+#include <algorithm>
+#include <cstdlib>
+#include <QElapsedTimer>
 #include <schematic.h>
+#include <schematic_wire.hpp>
+#include <wire_router.hpp>
+#include <logger.hpp>
 
 namespace gui_qt {
 
     qreal SchComponent::bodyThick = 0.0;
     qreal SchComponent::termThick = 0.0;
+    qreal SchWire::thick = 0.0;
+    QPen SchComponent::bodyPen;
+    QPen SchComponent::termPen;
+    QPen SchWire::pen;
+    std::map<std::tuple<int, int, int, long, int>, SchComponent::SymbolPixmap> SchComponent::symbolCache;
 
     Schematic::Schematic(gui::GuiSchematicInterfaceInt* ifc, QWidget *parent)
         : QDialog(parent), m_ifc(ifc) {
@@ -13,7 +27,7 @@ namespace gui_qt {
         m_scene = new QGraphicsScene();
         m_view = new GraphicsView(m_scene);
 
-        m_scene->setSceneRect(0, 0, L2P(g_logSchWidth), L2P(g_logSchHeight));
+        resetSheet();
         m_view->setRenderHints(QPainter::Antialiasing | QPainter::SmoothPixmapTransform);
         m_view->setDragMode(QGraphicsView::ScrollHandDrag);
         m_view->setTransformationAnchor(QGraphicsView::AnchorUnderMouse);
@@ -23,42 +37,391 @@ namespace gui_qt {
         m_view->showMaximized();
 
         setThickness(Qt::Key_1);
+        if(const char* gl = std::getenv("SPICE_VISUALIZER_OPENGL"); gl != nullptr && *gl != '\0') {
+            m_view->toggleOpenGl();
+        }
+        m_view->setDrillIn([this](const std::string& instance) { drillIn(instance); });
         grabKeyboard();
 
-        tmpGuiTest();
+        connect(this, SIGNAL(signalNewData()), this, SLOT(slotNewData()));
     }
 
     Schematic::~Schematic() {
         delete m_view;
         delete m_scene;
+        SchComponent::clearSymbolCache();
+    }
+
+    //nullptr for components without a symbol. Components without a
+    //recommendation are drawn with terminal 1 facing left.
+    SchComponent* Schematic::createComponent(const gui::SchematicItem& item) {
+        const auto& recomm = item.recommendation.empty() ? std::string("LEFT") : item.recommendation;
+        const auto& refTerm = item.refTerminal.empty() ? std::string("1") : item.refTerminal;
+        const char type = item.type.empty() ? ' ' : std::toupper(static_cast<unsigned char>(item.type.front()));
+
+        SchComponent* comp = nullptr;
+        if(type == 'R') {
+            comp = new Resistor(recomm, refTerm, item.name, item.value, item.connections);
+        } else if(type == 'C') {
+            comp = new Capacitor(recomm, refTerm, item.name, item.value, item.connections);
+        } else if(type == 'Q') {
+            comp = new NpnTransistor(recomm, refTerm, item.name, item.value, item.connections);
+        } else if(type == 'X') {
+            comp = new SubcircuitInstance(recomm, refTerm, item.name, item.value, item.connections);
+        } else {
+            return nullptr;
+        }
+
+        comp->setComponentPos(refTerm, QPointF(item.x, item.y));
+        return comp;
     }
 
-    void Schematic::tmpGuiTest() {
-        //Temporary test
-        SchComponent* res = new Resistor("LEFT", "1", "R1", "1000k");
-        res->setComponentPos("2", QPointF(30, 10));
-        m_scene->addItem(res);
+    //nullptr-free, components without a symbol are logged and left out
+    std::vector<SchComponent*> Schematic::createComponents(const std::vector<gui::SchematicItem>& items) {
+        std::size_t skipped = 0;
+        std::vector<SchComponent*> components;
+        components.reserve(items.size());
+        for(const auto& item : items) {
+            try {
+                auto* const comp = createComponent(item);
+                if(comp != nullptr) {
+                    components.emplace_back(comp);
+                    continue;
+                }
+            } catch(const std::runtime_error& e) {
+                logging::error(e.what());
+            }
+            ++skipped;
+        }
 
-        SchComponent* cap = new Capacitor("UP", "1", "C123", "1n");
-        cap->setComponentPos("1", QPointF(40, 10));
-        m_scene->addItem(cap);
+        if(skipped != 0) {
+            logging::info(skipped, " of ", items.size(), " components not shown, no schematic symbol");
+        }
+        return components;
+    }
 
-        SchComponent* tran = new NpnTransistor("DOWN", "3", "Q2", "BC548B");
-        tran->setComponentPos("2", QPointF(50, 10));
-        m_scene->addItem(tran);
+    void Schematic::slotNewData() {
+        const auto batches = m_ifc->takeBatches();
+        if(batches.empty()) {
+            return;
+        }
+        for(const auto& batch : batches) {
+            if(batch.full) {
+                insertAll(batch);
+            } else {
+                insertDelta(batch);
+            }
+        }
+        m_view->measureNextFrame(batches.back().published);
+    }
+
+    //Items are added with the scene index and the view updates off, so adding
+    //is cheap and nothing is drawn half way. The BSP index is built once for
+    //all items when it is turned back on.
+    void Schematic::insertAll(const gui::SchematicBatch& batch) {
+        QElapsedTimer timer;
+        timer.start();
+
+        const auto components = createComponents(batch.items);
+        logging::debug("Schematic: ", components.size(), " components created in ", timer.elapsed(), " ms");
+
+        m_view->setUpdatesEnabled(false);
+        m_scene->setItemIndexMethod(QGraphicsScene::NoIndex);
+        m_scene->clear();
+        m_components.clear();
+        m_wires.clear();
+        m_netMembers.clear();
+        resetSheet();
+
+        QRectF bounds;
+        std::unordered_set<std::string> nets;
+        for(auto* const comp : components) {
+            addComponent(comp, nets);
+            bounds |= comp->sceneBoundingRect();
+        }
+        std::vector<SchWire*> wires;
+        bounds |= routeWires(nets, wires);
+        growSheet(bounds);
+        buildOverview();
+
+        m_scene->setBspTreeDepth(getBspTreeDepth(components.size() + wires.size()));
+        m_scene->setItemIndexMethod(QGraphicsScene::BspTreeIndex);
+        m_view->setUpdatesEnabled(true);
+
+        m_level = batch.level;
+        std::string path;
+        for(const auto& instance : m_level) {
+            path += "/" + instance;
+        }
+        setWindowTitle(QString::fromStdString(path.empty() ? std::string("/") : path));
+
+        logging::info("Schematic: ", components.size(), " components inserted in ", timer.elapsed(), " ms");
+    }
+
+    //Replaces only the components of the batch and the wires of the nets they
+    //were or are attached to, the scene index is updated item by item
+    void Schematic::insertDelta(const gui::SchematicBatch& batch) {
+        QElapsedTimer timer;
+        timer.start();
+
+        const auto components = createComponents(batch.items);
+
+        std::unordered_set<std::string> nets;
+        auto removeNamed = [&](const std::string& name) {
+            const auto it = m_components.find(name);
+            if(it != m_components.end()) {
+                removeComponent(it->second, nets);
+            }
+        };
+        for(const auto& name : batch.removed) {
+            removeNamed(name);
+        }
+        for(const auto& item : batch.items) {
+            removeNamed(item.name);
+        }
+
+        auto* const overview = m_view->getOverview();
+        QRectF bounds;
+        for(auto* const comp : components) {
+            addComponent(comp, nets);
+            bounds |= comp->sceneBoundingRect();
+            if(overview != nullptr) {
+                const auto rect = comp->getLogSceneRect();
+                overview->addRect(QRectF(L2P(rect.topLeft()), L2P(rect.bottomRight())));
+            }
+        }
+        for(const auto& net : nets) {
+            removeWire(net);
+        }
+
+        std::vector<SchWire*> wires;
+        bounds |= routeWires(nets, wires);
+
+        const auto sheet = m_scene->sceneRect();
+        growSheet(bounds);
+        if(overview == nullptr || m_scene->sceneRect() != sheet) {
+            buildOverview();
+        } else {
+            for(const auto* wire : wires) {
+                for(const auto& line : wire->getLines()) {
+                    overview->addLine(line);
+                }
+            }
+            overview->finish();
+            m_view->viewport()->update();
+        }
+
+        logging::info("Schematic: ", components.size(), " components replaced, ", batch.removed.size(), " removed, ",
+                      wires.size(), " nets routed again in ", timer.elapsed(), " ms");
+    }
+
+    //'nets' gets the nets the component is attached to
+    void Schematic::addComponent(SchComponent* comp, std::unordered_set<std::string>& nets) {
+        m_scene->addItem(comp);
+        m_components.emplace(comp->getName(), comp);
+        comp->forEachConnection([&](const std::string& conn, const QPointF& /* pos */) {
+                nets.insert(conn);
+                m_netMembers[conn].insert(comp);
+                });
+    }
+
+    //Deletes the component, 'nets' gets the nets it was attached to
+    void Schematic::removeComponent(SchComponent* comp, std::unordered_set<std::string>& nets) {
+        comp->forEachConnection([&](const std::string& conn, const QPointF& /* pos */) {
+                nets.insert(conn);
+                const auto members = m_netMembers.find(conn);
+                if(members != m_netMembers.end()) {
+                    members->second.erase(comp);
+                    if(members->second.empty()) {
+                        m_netMembers.erase(members);
+                    }
+                }
+                });
+        if(auto* const overview = m_view->getOverview()) {
+            const auto rect = comp->getLogSceneRect();
+            overview->removeRect(QRectF(L2P(rect.topLeft()), L2P(rect.bottomRight())));
+        }
+        m_components.erase(comp->getName());
+        m_scene->removeItem(comp);
+        delete comp;
+    }
+
+    void Schematic::removeWire(const std::string& net) {
+        const auto it = m_wires.find(net);
+        if(it == m_wires.end()) {
+            return;
+        }
+        auto* const wire = it->second;
+        if(auto* const overview = m_view->getOverview()) {
+            for(const auto& line : wire->getLines()) {
+                overview->removeLine(line);
+            }
+        }
+        m_wires.erase(it);
+        m_scene->removeItem(wire);
+        delete wire;
+    }
+
+    //Routes 'nets' between the terminals attached to them, which must have no
+    //wires in the scene. Symbols and the wires of other nets around them are
+    //avoided, those wires stay as they are. Returns the bounds of the new wires.
+    QRectF Schematic::routeWires(const std::unordered_set<std::string>& nets, std::vector<SchWire*>& wires) {
+        auto toGrid = [](const QPointF& log) {
+            return WirePoint{ static_cast<std::int32_t>(std::lround(log.x())), static_cast<std::int32_t>(std::lround(log.y())) };
+        };
+        auto addObstacle = [&](WireRouter& router, const SchComponent* comp) {
+            const auto rect = comp->getLogSceneRect();
+            const auto topLeft = toGrid(rect.topLeft());
+            const auto bottomRight = toGrid(rect.bottomRight());
+            router.addObstacle(WireObstacle{ topLeft.x, topLeft.y, bottomRight.x, bottomRight.y });
+        };
+
+        WireRouter router;
+        QRectF area;
+        std::size_t routed = 0;
+        for(const auto& net : nets) {
+            const auto members = m_netMembers.find(net);
+            if(members == m_netMembers.end()) {
+                continue;
+            }
+            std::vector<WirePoint> terminals;
+            for(const auto* comp : members->second) {
+                comp->forEachConnection([&](const std::string& conn, const QPointF& pos) {
+                        if(conn == net) {
+                            terminals.emplace_back(toGrid(pos));
+                        }
+                        });
+            }
+            const auto [minX, maxX] = std::minmax_element(terminals.begin(), terminals.end(), [](const auto& a, const auto& b) { return a.x < b.x; });
+            const auto [minY, maxY] = std::minmax_element(terminals.begin(), terminals.end(), [](const auto& a, const auto& b) { return a.y < b.y; });
+            const auto margin = m_logRerouteMargin + std::max(maxX->x - minX->x, maxY->y - minY->y) / 4;
+            area |= QRectF(L2P(QPointF(minX->x - margin, minY->y - margin)), L2P(QPointF(maxX->x + margin, maxY->y + margin)));
+            router.addNet(net, std::move(terminals));
+            ++routed;
+        }
+
+        if(routed == m_netMembers.size()) {
+            //Every net is routed, there are no wires to keep
+            for(const auto& comp : m_components) {
+                addObstacle(router, comp.second);
+            }
+        } else if(!area.isEmpty()) {
+            for(const auto* item : m_scene->items(area)) {
+                if(const auto* comp = dynamic_cast<const SchComponent*>(item)) {
+                    addObstacle(router, comp);
+                } else if(const auto* wire = dynamic_cast<const SchWire*>(item)) {
+                    for(const auto& line : wire->getLines()) {
+                        router.addFixedWire(WireSegment{ toGrid(P2L(line.p1())), toGrid(P2L(line.p2())) });
+                    }
+                }
+            }
+        }
+
+        router.run();
+
+        QRectF bounds;
+        for(std::size_t netIdx = 0; netIdx < router.getNetsCount(); ++netIdx) {
+            const auto& segments = router.getWires(netIdx);
+            if(!segments.empty()) {
+                auto* const wire = new SchWire(router.getNetName(netIdx), segments);
+                m_scene->addItem(wire);
+                m_wires.emplace(wire->getName(), wire);
+                bounds |= wire->sceneBoundingRect();
+                wires.emplace_back(wire);
+            }
+        }
+        return bounds;
+    }
+
+    //Symbol bodies and wire segments rasterized over the whole sheet, for the zoomed out view
+    void Schematic::buildOverview() {
+        QElapsedTimer timer;
+        timer.start();
+
+        auto overview = std::make_unique<SchOverview>(m_scene->sceneRect());
+        for(const auto& comp : m_components) {
+            const auto rect = comp.second->getLogSceneRect();
+            overview->addRect(QRectF(L2P(rect.topLeft()), L2P(rect.bottomRight())));
+        }
+        for(const auto& wire : m_wires) {
+            for(const auto& line : wire.second->getLines()) {
+                overview->addLine(line);
+            }
+        }
+        overview->finish();
+        m_view->setOverview(std::move(overview));
+
+        logging::debug("Schematic: overview built in ", timer.elapsed(), " ms");
+    }
+
+    void Schematic::resetSheet() {
+        m_bounds = QRectF();
+        m_scene->setSceneRect(0, 0, L2P(g_logSchWidth), L2P(g_logSchHeight));
+        m_view->setOverview(nullptr);
+        m_view->resetCachedContent();
+    }
+
+    //The sheet only grows, in whole grid units, to keep 'bounds' and a margin
+    //around them on it. The background cache is dropped when it does.
+    void Schematic::growSheet(const QRectF& bounds) {
+        if(bounds.isEmpty()) {
+            return;
+        }
+        m_bounds |= bounds;
+
+        const auto margin = L2P(g_logSchMargin);
+        const auto wanted = m_bounds.adjusted(-margin, -margin, margin, margin);
+        const QPointF topLeft(L2P(std::floor(P2L(wanted.left()))), L2P(std::floor(P2L(wanted.top()))));
+        const QPointF bottomRight(L2P(std::ceil(P2L(wanted.right()))), L2P(std::ceil(P2L(wanted.bottom()))));
+        const auto sheet = m_scene->sceneRect() | QRectF(topLeft, bottomRight);
+        if(sheet != m_scene->sceneRect()) {
+            m_scene->setSceneRect(sheet);
+            m_view->resetCachedContent();
+        }
+    }
+
+    //Qt's automatic depth follows log2 of the item count, leaving about one
+    //item per leaf. Items overlapping several leaves are then stored many
+    //times, so the depth is chosen for m_itemsPerBspLeaf items per leaf.
+    int Schematic::getBspTreeDepth(std::size_t itemsCount) {
+        int depth = 1;
+        while(depth < m_maxBspTreeDepth && (itemsCount >> depth) > m_itemsPerBspLeaf) {
+            ++depth;
+        }
+        return depth;
     }
 
     void Schematic::toggleGrid(int /* key */) const {
         m_view->toggleGrid();
     }
 
+    void Schematic::toggleViewport(int /* key */) const {
+        m_view->toggleOpenGl();
+    }
+
+    //The circuit is shown once the processing thread has expanded and laid it out
+    void Schematic::drillIn(const std::string& instance) {
+        auto level = m_level;
+        level.emplace_back(instance);
+        m_ifc->requestLevel(std::move(level));
+    }
+
+    void Schematic::drillOut(int /* key */) {
+        if(!m_level.empty()) {
+            m_ifc->requestLevel(std::vector<std::string>(m_level.begin(), m_level.end() - 1));
+        }
+    }
+
     void Schematic::setThickness(int key) const {
         if(key == Qt::Key_1) {
             SchComponent::setThickness(0.3, 0.1);
+            SchWire::setThickness(0.1);
         } else if(key == Qt::Key_2) {
             SchComponent::setThickness(0.4, 0.2);
+            SchWire::setThickness(0.2);
         } else if(key == Qt::Key_3) {
             SchComponent::setThickness(0.6, 0.3);
+            SchWire::setThickness(0.3);
         }
         m_scene->update();
     }
@@ -89,15 +452,12 @@ namespace gui_qt {
     }
 
     void Schematic::showAll(int /* key */) const {
-        m_view->fitInView(0,
-                          0,
-                          L2P(g_logSchWidth),
-                          L2P(g_logSchHeight),
+        m_view->fitInView(m_scene->sceneRect(),
                           Qt::KeepAspectRatio);
     }
 
     void Schematic::showOptimal(int /* key */) const {
-        m_view->fitInView(m_scene->itemsBoundingRect(),
+        m_view->fitInView(m_bounds.isEmpty() ? m_scene->sceneRect() : m_bounds,
                           Qt::KeepAspectRatio);
     }
 
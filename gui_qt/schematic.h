@@ -4,19 +4,105 @@
 #include <QDialog>
 #include <QGraphicsScene>
 #include <QGraphicsView>
+#include <QOpenGLWidget>
+#include <QOpenGLContext>
+#include <QSurfaceFormat>
 #include <QWheelEvent>
+#include <QMouseEvent>
+#include <QVector>
+#include <QLineF>
 #include <qmath.h>
+#include <cmath>
+#include <algorithm>
 #include <functional>
 #include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <memory>
 #include <schematic_component.hpp>
+#include <schematic_wire.hpp>
+#include <schematic_overview.hpp>
 #include <gui_schematic_interface.hpp>
+#include <logger.hpp>
 
 namespace gui_qt {
 
     class GraphicsView : public QGraphicsView {
+        //Grid lines closer than this (in pixels) are thinned out by 10x
+        static constexpr qreal m_minGridPixels = 5;
+        static constexpr std::size_t m_framesPerLog = 120;
+        //Below this scale the overview is drawn instead of the items
+        static constexpr qreal m_overviewDetails = 0.0625;
+
         bool m_gridEnable;
+        bool m_openGl;
+        bool m_measureFrame;
+        std::chrono::steady_clock::time_point m_published;
+
+        //Paint times since the last log
+        std::size_t m_frames;
+        std::chrono::steady_clock::duration m_frameTime;
+        std::chrono::steady_clock::duration m_maxFrameTime;
+
+        std::unique_ptr<SchOverview> m_overview;
+
+        //Called with the name of a subcircuit instance double clicked
+        std::function<void(const std::string&)> m_drillIn;
+
+        //Grid and overview only, the scene and its index are not visited
+        void paintOverview(QPaintEvent* e) {
+            QPainter painter(viewport());
+            painter.setRenderHints(renderHints());
+            painter.setWorldTransform(viewportTransform());
+            drawBackground(&painter, mapToScene(e->rect()).boundingRect());
+            m_overview->draw(&painter);
+        }
+
+        void countFrame(std::chrono::steady_clock::duration time) {
+            ++m_frames;
+            m_frameTime += time;
+            m_maxFrameTime = std::max(m_maxFrameTime, time);
+            if(m_frames == m_framesPerLog) {
+                auto toMs = [](auto d) { return std::chrono::duration<double, std::milli>(d).count(); };
+                logging::debug("Schematic: ", m_frames, " frames, avg ", toMs(m_frameTime) / m_frames,
+                               " ms, max ", toMs(m_maxFrameTime), " ms");
+                m_frames = 0;
+                m_frameTime = m_maxFrameTime = std::chrono::steady_clock::duration::zero();
+            }
+        }
 
         protected:
+            void paintEvent(QPaintEvent* e) override {
+                const auto begin = std::chrono::steady_clock::now();
+                if(m_overview && transform().m11() < m_overviewDetails) {
+                    paintOverview(e);
+                } else {
+                    QGraphicsView::paintEvent(e);
+                }
+                countFrame(std::chrono::steady_clock::now() - begin);
+                if(m_measureFrame) {
+                    m_measureFrame = false;
+                    const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - m_published);
+                    logging::info("Schematic: first frame ", ms.count(), " ms after the data was published");
+                }
+            }
+
+            void mouseDoubleClickEvent(QMouseEvent* e) override {
+                if(m_drillIn) {
+                    for(const auto* item : items(e->pos())) {
+                        if(const auto* instance = dynamic_cast<const SubcircuitInstance*>(item)) {
+                            m_drillIn(instance->getName());
+                            e->accept();
+                            return;
+                        }
+                    }
+                }
+                QGraphicsView::mouseDoubleClickEvent(e);
+            }
+
             void wheelEvent(QWheelEvent* e) override {
                 if(e->modifiers() & Qt::ControlModifier) {
                     auto exp = (e->delta() > 0) ? g_scaleExp : -g_scaleExp;
@@ -28,39 +114,120 @@ namespace gui_qt {
                 }
             }
 
+            //Only lines crossing the exposed part of the sheet are drawn. The view
+            //caches the background per zoom level (CacheBackground), so panning
+            //draws just the strips scrolled into view.
             void drawBackground(QPainter* painter, const QRectF& rect) override {
-                if(m_gridEnable) {
-                    painter->setClipRect(rect);
-                    painter->setPen(QPen(Qt::lightGray, 0));
-                    const qreal details = transform().m11();
-                    const std::size_t delta = (details > 0.5) ? 1 : 10;
-
-                    for(std::size_t i = 0; i <= g_logSchWidth; i += delta) {
-                        painter->drawLine(L2P(i), 0, L2P(i), L2P(g_logSchHeight));
-                    }
+                //An OpenGL viewport is not filled by the widget
+                if(m_openGl) {
+                    painter->fillRect(rect, palette().brush(QPalette::Base));
+                }
+                if(!m_gridEnable) {
+                    return;
+                }
 
-                    for(std::size_t i = 0; i <= g_logSchHeight; i += delta) {
-                        painter->drawLine(0, L2P(i), L2P(g_logSchWidth), L2P(i));
-                    }
+                const auto sheet = sceneRect();
+                const auto area = rect & sheet;
+                const qreal scale = transform().m11();
+                qreal delta = 1;
+                while(L2P(delta) * scale < m_minGridPixels) {
+                    delta *= 10;
+                }
+                if(area.isEmpty() || L2P(delta) > std::max(sheet.width(), sheet.height())) {
+                    return;
+                }
+
+                const auto step = L2P(delta);
+                QVector<QLineF> lines;
+                for(auto i = std::ceil(area.left() / step); i * step <= area.right(); ++i) {
+                    lines.append(QLineF(i * step, area.top(), i * step, area.bottom()));
+                }
+                for(auto i = std::ceil(area.top() / step); i * step <= area.bottom(); ++i) {
+                    lines.append(QLineF(area.left(), i * step, area.right(), i * step));
                 }
+
+                painter->save();
+                painter->setRenderHint(QPainter::Antialiasing, false);
+                painter->setPen(QPen(Qt::lightGray, 0));
+                painter->drawLines(lines);
+                painter->restore();
             }
 
         public:
             GraphicsView(QGraphicsScene* scene)
-                : QGraphicsView(scene), m_gridEnable(true) {}
+                : QGraphicsView(scene), m_gridEnable(true), m_openGl(false), m_measureFrame(false), m_frames(0),
+                m_frameTime(std::chrono::steady_clock::duration::zero()),
+                m_maxFrameTime(std::chrono::steady_clock::duration::zero()) {
+                setCacheMode(QGraphicsView::CacheBackground);
+            }
             virtual ~GraphicsView() = default;
 
+            //Logs the time from 'published' to the end of the next paint
+            void measureNextFrame(std::chrono::steady_clock::time_point published) {
+                m_published = published;
+                m_measureFrame = true;
+                viewport()->update();
+            }
+
+            //Replaces the overview of the previous layout, nullptr for none
+            void setOverview(std::unique_ptr<SchOverview> overview) {
+                m_overview = std::move(overview);
+                viewport()->update();
+            }
+
+            void setDrillIn(std::function<void(const std::string&)> drillIn) {
+                m_drillIn = std::move(drillIn);
+            }
+
+            //nullptr when there is none, call finish() on it after changing it
+            SchOverview* getOverview() const {
+                return m_overview.get();
+            }
+
             void toggleGrid() {
                 auto* const v = viewport();
                 m_gridEnable = !m_gridEnable;
+                resetCachedContent();
                 v->update();
             }
+
+            //Switches between the raster viewport and an OpenGL one, which Mesa
+            //provides through llvmpipe on machines without a GPU. The OpenGL
+            //viewport is always repainted whole, the grid is drawn directly
+            //instead of from the background cache.
+            void toggleOpenGl() {
+                if(!m_openGl) {
+                    QOpenGLContext context;
+                    if(!context.create()) {
+                        logging::error("Schematic: no OpenGL context, keeping the raster viewport");
+                        return;
+                    }
+                    auto* const gl = new QOpenGLWidget();
+                    QSurfaceFormat format;
+                    format.setSamples(4);
+                    gl->setFormat(format);
+                    setViewport(gl);
+                    setViewportUpdateMode(QGraphicsView::FullViewportUpdate);
+                    setCacheMode(QGraphicsView::CacheNone);
+                } else {
+                    setViewport(new QWidget());
+                    setViewportUpdateMode(QGraphicsView::SmartViewportUpdate);
+                    setCacheMode(QGraphicsView::CacheBackground);
+                }
+                m_openGl = !m_openGl;
+                resetCachedContent();
+                logging::info("Schematic: ", (m_openGl) ? "OpenGL" : "raster", " viewport");
+            }
     };
 
     class Schematic : public QDialog {
         Q_OBJECT
 
         public slots:
+            void slotNewData();
+
+        signals:
+            void signalNewData();
 
         public:
             Schematic(gui::GuiSchematicInterfaceInt* ifc, QWidget *parent = 0);
@@ -72,28 +239,62 @@ namespace gui_qt {
             GraphicsView* m_view;
             gui::GuiSchematicInterfaceInt* m_ifc;
 
+            //Bounds of all items, the sheet is these plus a margin
+            QRectF m_bounds;
+
+            //Subcircuit instances leading to the circuit shown, empty for the netlist
+            std::vector<std::string> m_level;
+
+            //Items in the scene by component and by net name, and the components attached to every net
+            std::unordered_map<std::string, SchComponent*> m_components;
+            std::unordered_map<std::string, SchWire*> m_wires;
+            std::unordered_map<std::string, std::unordered_set<SchComponent*>> m_netMembers;
+
+            //Scene index leaves are meant to hold about this many items
+            static constexpr std::size_t m_itemsPerBspLeaf = 16;
+            static constexpr int m_maxBspTreeDepth = 16;
+            //Symbols and wires this far (logical units) around a net routed again are taken
+            //into account, plus a quarter of its span, as the router searches that far
+            static constexpr qreal m_logRerouteMargin = 8;
+
             void toggleGrid(int key) const;
+            void toggleViewport(int key) const;
+            void drillIn(const std::string& instance);
+            void drillOut(int key);
             void setThickness(int key) const;
             void zoomSchematic(int key) const;
             void scrollSchematic(int key) const;
             void showAll(int key) const;
             void showOptimal(int key) const;
 
-            void tmpGuiTest();
+            static SchComponent* createComponent(const gui::SchematicItem& item);
+            static std::vector<SchComponent*> createComponents(const std::vector<gui::SchematicItem>& items);
+            void insertAll(const gui::SchematicBatch& batch);
+            void insertDelta(const gui::SchematicBatch& batch);
+            void addComponent(SchComponent* comp, std::unordered_set<std::string>& nets);
+            void removeComponent(SchComponent* comp, std::unordered_set<std::string>& nets);
+            void removeWire(const std::string& net);
+            QRectF routeWires(const std::unordered_set<std::string>& nets, std::vector<SchWire*>& wires);
+            void buildOverview();
+            void resetSheet();
+            void growSheet(const QRectF& bounds);
+            static int getBspTreeDepth(std::size_t itemsCount);
 
             inline static const std::map<int, std::function<void(Schematic* const, int)>> m_keyCommands = {
-                { Qt::Key_G,        &Schematic::toggleGrid },
-                { Qt::Key_A,        &Schematic::showAll },
-                { Qt::Key_O,        &Schematic::showOptimal },
-                { Qt::Key_1,        &Schematic::setThickness },
-                { Qt::Key_2,        &Schematic::setThickness },
-                { Qt::Key_3,        &Schematic::setThickness },
-                { Qt::Key_PageUp,   &Schematic::zoomSchematic },
-                { Qt::Key_PageDown, &Schematic::zoomSchematic },
-                { Qt::Key_Left,     &Schematic::scrollSchematic },
-                { Qt::Key_Right,    &Schematic::scrollSchematic },
-                { Qt::Key_Up,       &Schematic::scrollSchematic },
-                { Qt::Key_Down,     &Schematic::scrollSchematic }
+                { Qt::Key_G,         &Schematic::toggleGrid },
+                { Qt::Key_V,         &Schematic::toggleViewport },
+                { Qt::Key_Backspace, &Schematic::drillOut },
+                { Qt::Key_A,         &Schematic::showAll },
+                { Qt::Key_O,         &Schematic::showOptimal },
+                { Qt::Key_1,         &Schematic::setThickness },
+                { Qt::Key_2,         &Schematic::setThickness },
+                { Qt::Key_3,         &Schematic::setThickness },
+                { Qt::Key_PageUp,    &Schematic::zoomSchematic },
+                { Qt::Key_PageDown,  &Schematic::zoomSchematic },
+                { Qt::Key_Left,      &Schematic::scrollSchematic },
+                { Qt::Key_Right,     &Schematic::scrollSchematic },
+                { Qt::Key_Up,        &Schematic::scrollSchematic },
+                { Qt::Key_Down,      &Schematic::scrollSchematic }
             };
     };
 
@@ -1,6 +1,8 @@
 #ifndef SCHEMATIC_COMPONENT
 #define SCHEMATIC_COMPONENT
 
+#include <QLineF>
+#include <algorithm>
 #include <schematic_component_base.hpp>
 
 namespace gui_qt {
@@ -25,7 +27,8 @@ namespace gui_qt {
         Resistor(const std::string& recomm,
                 const std::string& refTerm,
                 const std::string& name,
-                const std::string& value)
+                const std::string& value,
+                const std::vector<std::string>& connections)
             : SchComponent(logLength,
                     logWidth,
                     logMargin,
@@ -37,15 +40,17 @@ namespace gui_qt {
                         { "1", QPointF(0, logWidth / 2) },
                         { "2", QPointF(logLength, logWidth / 2) }
                     },
-                    {
-                        //tmp - this would be taken from graph traversal
-                        { "net1", "1" },
-                        { "net2", "2" }
-                    }) {
+                    connections) {
         }
 
         virtual ~Resistor() = default;
 
+        enum { Type = UserType + 1 };
+
+        virtual int type() const override {
+            return Type;
+        }
+
     };
 
     class Capacitor : public SchComponent {
@@ -69,7 +74,8 @@ namespace gui_qt {
         Capacitor(const std::string& recomm,
                 const std::string& refTerm,
                 const std::string& name,
-                const std::string& value)
+                const std::string& value,
+                const std::vector<std::string>& connections)
             : SchComponent(logLength,
                     logWidth,
                     logMargin,
@@ -81,14 +87,16 @@ namespace gui_qt {
                         { "1", QPointF(0, logWidth / 2) },
                         { "2", QPointF(logLength, logWidth / 2) }
                     },
-                    {
-                        //tmp - this would be taken from graph traversal
-                        { "net1", "1" },
-                        { "net2", "2" }
-                    }) {
+                    connections) {
         }
 
         virtual ~Capacitor() = default;
+
+        enum { Type = UserType + 2 };
+
+        virtual int type() const override {
+            return Type;
+        }
     };
 
     class NpnTransistor : public SchComponent {
@@ -97,6 +105,8 @@ namespace gui_qt {
         static constexpr qreal logWidth = 8;
         static constexpr qreal logMargin = 1;
 
+        inline static const QBrush arrowBrush = QBrush(Qt::black, Qt::SolidPattern);
+
         protected:
         void drawBody(QPainter* painter) const override {
             painter->drawLine(getL() / 2 - getM(), getM() * 2.5, getL() / 2 - getM(), getW() - getM() * 2.5);
@@ -111,7 +121,7 @@ namespace gui_qt {
                                                    QPointF(getL() - getM() * 4.25, getW() - getM() * 2.75),
                                                 };
             painter->setPen(getDrawingPen_T1());
-            painter->setBrush(QBrush(Qt::black, Qt::SolidPattern));
+            painter->setBrush(arrowBrush);
             painter->drawPolygon(arrowPoints, 3);
         }
 
@@ -125,7 +135,8 @@ namespace gui_qt {
         NpnTransistor(const std::string& recomm,
                 const std::string& refTerm,
                 const std::string& name,
-                const std::string& value)
+                const std::string& value,
+                const std::vector<std::string>& connections)
             : SchComponent(logLength,
                     logWidth,
                     logMargin,
@@ -139,15 +150,86 @@ namespace gui_qt {
                         { "2", QPointF(0, logWidth / 2) },
                         { "3", QPointF(logLength - logMargin * 3, logWidth) }
                     },
-                    {
-                        //tmp - this would be taken from graph traversal
-                        { "net1", "1" },
-                        { "net2", "2" },
-                        { "net3", "3" }
-                    }) {
+                    connections) {
         }
 
         virtual ~NpnTransistor() = default;
+
+        enum { Type = UserType + 3 };
+
+        virtual int type() const override {
+            return Type;
+        }
+    };
+
+    //Box of a subcircuit instance with its ports along the left edge, in
+    //instance order. Double clicking it shows the circuit of the subcircuit.
+    class SubcircuitInstance : public SchComponent {
+
+        static constexpr qreal logLength = 6;
+        static constexpr qreal logMargin = 1;
+        //Distance between ports, as in circuit/placement.hpp
+        static constexpr qreal logPortPitch = 2;
+
+        std::size_t m_ports;
+
+        static qreal getLogPortY(std::size_t idx) {
+            return logPortPitch * idx + logPortPitch / 2;
+        }
+
+        static qreal getLogWidth(std::size_t ports) {
+            return logPortPitch * std::max<std::size_t>(ports, 1);
+        }
+
+        static std::map<std::string, QPointF> getPorts(std::size_t ports) {
+            std::map<std::string, QPointF> termToPos;
+            for(std::size_t idx = 0; idx < ports; ++idx) {
+                termToPos.emplace(std::to_string(idx + 1), QPointF(0, getLogPortY(idx)));
+            }
+            return termToPos;
+        }
+
+        protected:
+        void drawBody(QPainter* painter) const override {
+            painter->drawRect(QRectF(getM(), 0, getL() - getM(), getW()));
+        }
+
+        void drawTerminals(QPainter* painter) const override {
+            for(std::size_t idx = 0; idx < m_ports; ++idx) {
+                const auto y = L2P(getLogPortY(idx));
+                painter->drawLine(QLineF(0, y, getM(), y));
+            }
+        }
+
+        int getSymbolVariant() const override {
+            return static_cast<int>(m_ports);
+        }
+
+        public:
+        SubcircuitInstance(const std::string& recomm,
+                const std::string& refTerm,
+                const std::string& name,
+                const std::string& value,
+                const std::vector<std::string>& connections)
+            : SchComponent(logLength,
+                    getLogWidth(connections.size()),
+                    logMargin,
+                    recomm,
+                    refTerm,
+                    name,
+                    value,
+                    getPorts(connections.size()),
+                    connections),
+            m_ports(connections.size()) {
+        }
+
+        virtual ~SubcircuitInstance() = default;
+
+        enum { Type = UserType + 4 };
+
+        virtual int type() const override {
+            return Type;
+        }
     };
 
 }
@@ -3,10 +3,17 @@
 
 #include <QGraphicsItem>
 #include <QStyleOptionGraphicsItem>
+#include <QStaticText>
+#include <QTransform>
+#include <QPainter>
+#include <QPixmap>
 #include <tuple>
 #include <map>
+#include <vector>
+#include <string>
 #include <cmath>
 #include <schematic_params.hpp>
+#include <label_font.hpp>
 
 namespace gui_qt {
 
@@ -20,36 +27,32 @@ namespace gui_qt {
         qreal m_width;
         qreal m_margin;
 
-        QFont m_font;
         qreal m_metrics;
 
+        //Name and value, laid out on their first draw and drawn upright below or beside the body
+        QStaticText m_nameText;
+        QStaticText m_valueText;
+        QPointF m_namePos;
+        QPointF m_valuePos;
+        QTransform m_infoTransform;
+
         std::string m_name;
         std::string m_value;
 
         std::map<std::string, QPointF> m_termToLogItemPos;
-        std::map<std::string, std::string> m_connToTerm;
+        std::multimap<std::string, std::string> m_connToTerm;
 
         QRectF getComponentRect() const {
             return QRectF(0, 0, m_length, m_width);
         }
 
         void drawInfo(QPainter* painter) const {
-            auto angle = rotation();
-            auto vertical = std::abs(angle) == qreal(90);
-            auto align = (vertical) ? Qt::AlignVCenter | Qt::AlignLeft
-                                    : Qt::AlignTop | Qt::AlignHCenter;
-            auto offset = (vertical) ? QPointF((getL() + getW() - getM()) / 2, 0)
-                                     : QPointF(0, getW() - getM() / 2);
-            auto str = QString(m_name.c_str()) + QString("\n") + QString(m_value.c_str());
-
-            painter->save();
-            painter->translate(getComponentRect().center());
-            painter->rotate(-angle);
-            painter->translate(-getComponentRect().center());
-            painter->translate(offset);
-            painter->setFont(m_font);
-            painter->drawText(getComponentRect(), align, str);
-            painter->restore();
+            const auto transform = painter->worldTransform();
+            painter->setWorldTransform(m_infoTransform, true);
+            painter->setFont(LabelFont::instance().getFont());
+            painter->drawStaticText(m_namePos, m_nameText);
+            painter->drawStaticText(m_valuePos, m_valueText);
+            painter->setWorldTransform(transform);
         }
 
         qreal getRotationAngle(const std::string& recomm, const QPointF& refTermLogItemPos) const {
@@ -79,11 +82,39 @@ namespace gui_qt {
         }
 
         void setComponentFont() {
+            const auto& font = LabelFont::instance();
             auto vertical = std::abs(rotation()) == qreal(90);
-            m_font = QFont("Courier New", 8, QFont::Normal);
-            QFontMetrics fm(m_font);
-            m_metrics = (vertical) ? std::max(fm.width(m_name.c_str()), fm.width(m_value.c_str()))
-                                   : fm.height() * 2;
+            m_metrics = (vertical) ? std::max(font.getWidth(m_name), font.getWidth(m_value))
+                                   : font.getHeight() * 2;
+        }
+
+        void setInfoLabels() {
+            auto angle = rotation();
+            auto vertical = std::abs(angle) == qreal(90);
+
+            m_nameText.setTextFormat(Qt::PlainText);
+            m_valueText.setTextFormat(Qt::PlainText);
+            m_nameText.setText(QString::fromStdString(m_name));
+            m_valueText.setText(QString::fromStdString(m_value));
+
+            //Centered below a horizontal body, left aligned and vertically centered beside a vertical one
+            const auto& font = LabelFont::instance();
+            if(vertical) {
+                auto top = getW() / 2 - font.getHeight();
+                m_namePos = QPointF(0, top);
+                m_valuePos = QPointF(0, top + font.getHeight());
+            } else {
+                m_namePos = QPointF((getL() - font.getWidth(m_name)) / 2, 0);
+                m_valuePos = QPointF((getL() - font.getWidth(m_value)) / 2, font.getHeight());
+            }
+
+            auto offset = (vertical) ? QPointF((getL() + getW() - getM()) / 2, 0)
+                                     : QPointF(0, getW() - getM() / 2);
+            auto center = getComponentRect().center();
+            m_infoTransform = QTransform().translate(center.x(), center.y())
+                                          .rotate(-angle)
+                                          .translate(-center.x(), -center.y())
+                                          .translate(offset.x(), offset.y());
         }
 
         const std::string& getTermFromConn(const std::string& connection) const {
@@ -112,6 +143,16 @@ namespace gui_qt {
                     "' not found!");
         }
 
+        //Connection 'i' is attached to terminal i + 1, connections beyond the terminals of the symbol are not drawn
+        void setConnections(const std::vector<std::string>& connections) {
+            for(std::size_t i = 0; i < connections.size(); ++i) {
+                auto term = std::to_string(i + 1);
+                if(m_termToLogItemPos.count(term) != 0) {
+                    m_connToTerm.emplace(connections[i], std::move(term));
+                }
+            }
+        }
+
         const QPointF getTermLogScenePos(const std::string& term) const {
             auto termPos = getTermLogItemPos(term);
             auto angle = rotation();
@@ -121,6 +162,13 @@ namespace gui_qt {
         static qreal bodyThick;
         static qreal termThick;
 
+        //Shared by all items, rebuilt by setThickness() so paint() does not create pens
+        static QPen bodyPen;
+        static QPen termPen;
+
+        inline static const QPen infoPen = QPen(Qt::black);
+        inline static const QBrush noBrush = QBrush(Qt::NoBrush);
+
         inline static const auto rotateVector = [](auto vector, auto angle) {
             constexpr qreal pi = std::acos(-1);
             auto nangle = pi * angle / qreal(180);
@@ -134,20 +182,90 @@ namespace gui_qt {
             { { 1, -1, "RIGHT" },  90 }, { { 1, -1, "LEFT"  }, -90 }, { { 1, -1, "UP"    },   0 }, { { 1, -1, "DOWN"  }, 180 },
             { { 1,  1, "RIGHT" }, -90 }, { { 1,  1, "LEFT"  },  90 }, { { 1,  1, "UP"    }, 180 }, { { 1,  1, "DOWN"  },   0 },
             { {-1,  1, "RIGHT" }, 180 }, { {-1,  1, "LEFT"  },   0 }, { {-1,  1, "UP"    },  90 }, { {-1,  1, "DOWN"  }, -90 },
+            { {-1, -1, "RIGHT" }, 180 }, { {-1, -1, "LEFT"  },   0 }, { {-1, -1, "UP"    },  90 }, { {-1, -1, "DOWN"  }, -90 },
+        };
+
+        static const QPen& getBodyPen() {
+            return bodyPen;
+        }
+
+        static const QPen& getTerminalPen() {
+            return termPen;
+        }
+
+        //Body and terminals as drawn at one zoom bucket, in device orientation
+        struct SymbolPixmap {
+            QPixmap pixmap;
+            QPointF origin;
         };
 
-        static QPen getBodyPen() {
-            return QPen(Qt::black, L2P(bodyThick), Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin);
+        static constexpr int symbolBucketsPerOctave = 4;
+        static constexpr qreal maxSymbolPixels = 256;
+        static constexpr std::size_t maxSymbolsCached = 256;
+
+        //By item type, symbol variant, rotation, zoom bucket and device pixel ratio, emptied by setThickness()
+        static std::map<std::tuple<int, int, int, long, int>, SymbolPixmap> symbolCache;
+
+        SymbolPixmap renderSymbol(const QPainter* painter, qreal scale) const {
+            const auto ratio = painter->device()->devicePixelRatio();
+            const auto pad = L2P(std::max(bodyThick, termThick)) * scale / 2 + 1;
+            const auto transform = QTransform().rotate(rotation()) * QTransform::fromScale(scale, scale);
+            const auto rect = transform.mapRect(getComponentRect()).adjusted(-pad, -pad, pad, pad);
+
+            QPixmap pixmap((rect.size() * ratio).toSize() + QSize(1, 1));
+            pixmap.setDevicePixelRatio(ratio);
+            pixmap.fill(Qt::transparent);
+
+            QPainter symbolPainter(&pixmap);
+            symbolPainter.setRenderHints(painter->renderHints());
+            symbolPainter.setTransform(transform * QTransform::fromTranslate(-rect.left(), -rect.top()));
+            symbolPainter.setBrush(noBrush);
+            symbolPainter.setPen(getBodyPen());
+            drawBody(&symbolPainter);
+            if(scale > 0.25) {
+                symbolPainter.setPen(getTerminalPen());
+                drawTerminals(&symbolPainter);
+            }
+            return SymbolPixmap{ pixmap, rect.topLeft() };
         }
 
-        static QPen getTerminalPen() {
-            return QPen(Qt::black, L2P(termThick), Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin);
+        //The view only scales and items are rotated by multiples of 90 degrees, so a symbol
+        //rendered once per zoom bucket is blitted with a small uniform scale.
+        //Returns false when the symbol is too large on screen to be worth caching.
+        bool drawCachedSymbol(QPainter* painter, qreal details) const {
+            const auto bucket = std::lround(std::log2(details) * symbolBucketsPerOctave);
+            const auto scale = std::exp2(qreal(bucket) / symbolBucketsPerOctave);
+            if(std::max(m_length, m_width) * scale > maxSymbolPixels) {
+                return false;
+            }
+
+            const auto key = std::make_tuple(type(), getSymbolVariant(), static_cast<int>(rotation()), bucket,
+                                             painter->device()->devicePixelRatio());
+            auto it = symbolCache.find(key);
+            if(it == symbolCache.end()) {
+                if(symbolCache.size() >= maxSymbolsCached) {
+                    symbolCache.clear();
+                }
+                it = symbolCache.emplace(key, renderSymbol(painter, scale)).first;
+            }
+
+            const auto world = painter->worldTransform();
+            const auto factor = details / scale;
+            painter->setWorldTransform(QTransform(factor, 0, 0, factor, world.dx(), world.dy()));
+            painter->drawPixmap(it->second.origin, it->second.pixmap);
+            painter->setWorldTransform(world);
+            return true;
         }
 
         protected:
         virtual void drawBody(QPainter* painter) const = 0;
         virtual void drawTerminals(QPainter* painter) const = 0;
 
+        //Tells apart the symbols of one item type drawn differently
+        virtual int getSymbolVariant() const {
+            return 0;
+        }
+
         qreal getL() const {
             return m_length;
         }
@@ -160,7 +278,7 @@ namespace gui_qt {
             return m_margin;
         }
 
-        static QPen getDrawingPen_T1() {
+        static const QPen& getDrawingPen_T1() {
             return getTerminalPen();
         }
 
@@ -168,6 +286,14 @@ namespace gui_qt {
         static void setThickness(qreal thBody, qreal thTerm) {
             bodyThick = thBody;
             termThick = thTerm;
+            bodyPen = QPen(Qt::black, L2P(bodyThick), Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin);
+            termPen = QPen(Qt::black, L2P(termThick), Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin);
+            symbolCache.clear();
+        }
+
+        //Pixmaps must not outlive the application, called before it is destroyed
+        static void clearSymbolCache() {
+            symbolCache.clear();
         }
 
         SchComponent(qreal logLength,
@@ -178,22 +304,27 @@ namespace gui_qt {
                     const std::string& name,
                     const std::string& value,
                     const std::map<std::string, QPointF>& termToPos,
-                    const std::map<std::string, std::string>& connToTerm)
+                    const std::vector<std::string>& connections)
             : m_length(L2P(logLength)),
             m_width(L2P(logWidth)),
             m_margin(L2P(logMargin)),
             m_name(name),
             m_value(value),
-            m_termToLogItemPos(termToPos),
-            m_connToTerm(connToTerm) {
+            m_termToLogItemPos(termToPos) {
 
+            setConnections(connections);
             setFlag(QGraphicsItem::ItemUsesExtendedStyleOption, true);
             setComponentOrientation(recomm, refTermName);
             setComponentFont();
+            setInfoLabels();
         }
 
         virtual ~SchComponent() = default;
 
+        const std::string& getName() const {
+            return m_name;
+        }
+
         void setComponentPos(const std::string& terminal, const QPointF& position) {
             auto termPos = getTermLogItemPos(terminal);
             auto angle = rotation();
@@ -201,6 +332,20 @@ namespace gui_qt {
             setPos(L2P(pos));
         }
 
+        //Symbol body in logical scene coordinates
+        QRectF getLogSceneRect() const {
+            const auto rect = mapRectToScene(getComponentRect());
+            return QRectF(P2L(rect.topLeft()), P2L(rect.bottomRight()));
+        }
+
+        //Calls fun(connection, terminal position in logical scene coordinates) for every connected terminal
+        template<typename TFun>
+        void forEachConnection(TFun&& fun) const {
+            for(const auto& conn : m_connToTerm) {
+                fun(conn.first, getTermLogScenePos(conn.second));
+            }
+        }
+
         virtual QRectF boundingRect() const override {
             return QRectF(0, -m_metrics, m_length, m_width + m_metrics * 2);
         }
@@ -209,7 +354,7 @@ namespace gui_qt {
                     const QStyleOptionGraphicsItem * opt,
                     QWidget *) override {
             painter->setClipRect(opt->exposedRect);
-            painter->setBrush(QBrush(Qt::NoBrush));
+            painter->setBrush(noBrush);
 
             const qreal details = opt->levelOfDetailFromTransform(painter->worldTransform());
             if(details < 0.0625) {
@@ -217,16 +362,18 @@ namespace gui_qt {
                 return;
             }
 
-            painter->setPen(getBodyPen());
-            drawBody(painter);
+            if(!drawCachedSymbol(painter, details)) {
+                painter->setPen(getBodyPen());
+                drawBody(painter);
 
-            if(details > 0.25) {
-                painter->setPen(getTerminalPen());
-                drawTerminals(painter);
+                if(details > 0.25) {
+                    painter->setPen(getTerminalPen());
+                    drawTerminals(painter);
+                }
             }
 
             if(details > 0.5) {
-                painter->setPen(Qt::black);
+                painter->setPen(infoPen);
                 drawInfo(painter);
             }
         }
@@ -0,0 +1,143 @@
+#ifndef SCHEMATIC_OVERVIEW
+#define SCHEMATIC_OVERVIEW
+
+#include <QPainter>
+#include <QPixmap>
+#include <QImage>
+#include <QRectF>
+#include <QLineF>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <schematic_params.hpp>
+
+namespace gui_qt {
+
+    //Density raster of a whole layout, drawn by the view instead of the items
+    //when zoomed out so far that the symbols are a few pixels wide. Built once
+    //per layout and patched where items are replaced, drawing it costs the
+    //same however many items it stands for.
+    class SchOverview {
+        //Cells per side at most and the smallest cell, in logical units
+        static constexpr int maxCells = 1024;
+        static constexpr qreal minLogCell = 1;
+        //Coverage of a cell shown fully opaque
+        static constexpr float fullCoverage = 0.25f;
+
+        QRectF m_rect;
+        qreal m_cell;
+        int m_columns;
+        int m_rows;
+
+        //Covered part of every cell, row by row
+        std::vector<float> m_coverage;
+        QImage m_image;
+        QPixmap m_pixmap;
+
+        //Cells changed since the last finish(), empty when left > right
+        int m_dirtyLeft;
+        int m_dirtyTop;
+        int m_dirtyRight;
+        int m_dirtyBottom;
+
+        //Adds 'weight' times the area 'rect' covers in each cell
+        void spread(const QRectF& rect, float weight) {
+            const auto clipped = rect.normalized() & m_rect;
+            if(clipped.isEmpty()) {
+                return;
+            }
+            const auto left = (clipped.left() - m_rect.left()) / m_cell;
+            const auto right = (clipped.right() - m_rect.left()) / m_cell;
+            const auto top = (clipped.top() - m_rect.top()) / m_cell;
+            const auto bottom = (clipped.bottom() - m_rect.top()) / m_cell;
+
+            const auto lastColumn = std::min(m_columns - 1, static_cast<int>(right));
+            const auto lastRow = std::min(m_rows - 1, static_cast<int>(bottom));
+            for(auto row = static_cast<int>(top); row <= lastRow; ++row) {
+                const auto h = std::min<qreal>(bottom, row + 1) - std::max<qreal>(top, row);
+                auto* const cells = &m_coverage[static_cast<std::size_t>(row) * m_columns];
+                for(auto col = static_cast<int>(left); col <= lastColumn; ++col) {
+                    const auto w = std::min<qreal>(right, col + 1) - std::max<qreal>(left, col);
+                    cells[col] += weight * static_cast<float>(w * h);
+                }
+            }
+            m_dirtyLeft = std::min(m_dirtyLeft, static_cast<int>(left));
+            m_dirtyTop = std::min(m_dirtyTop, static_cast<int>(top));
+            m_dirtyRight = std::max(m_dirtyRight, lastColumn);
+            m_dirtyBottom = std::max(m_dirtyBottom, lastRow);
+        }
+
+        //Wires are counted a quarter of a cell wide, so each one crossing a cell shows
+        QRectF getLineRect(const QLineF& line) const {
+            const auto half = m_cell / 8;
+            return QRectF(line.p1(), line.p2()).normalized().adjusted(-half, -half, half, half);
+        }
+
+        public:
+        explicit SchOverview(const QRectF& sheet)
+            : m_rect(sheet) {
+            m_cell = std::max(L2P(minLogCell), std::max(sheet.width(), sheet.height()) / maxCells);
+            m_columns = std::max(1, static_cast<int>(std::ceil(sheet.width() / m_cell)));
+            m_rows = std::max(1, static_cast<int>(std::ceil(sheet.height() / m_cell)));
+            m_rect.setSize(QSizeF(m_columns * m_cell, m_rows * m_cell));
+            m_coverage.assign(static_cast<std::size_t>(m_columns) * m_rows, 0.0f);
+            m_image = QImage(m_columns, m_rows, QImage::Format_ARGB32_Premultiplied);
+            m_dirtyLeft = m_dirtyTop = 0;
+            m_dirtyRight = m_columns - 1;
+            m_dirtyBottom = m_rows - 1;
+        }
+
+        virtual ~SchOverview() = default;
+
+        //Part of the scene the raster covers, items outside it are not shown
+        const QRectF& getRect() const {
+            return m_rect;
+        }
+
+        //'rect' in scene coordinates, spread over the cells by the area it covers in each
+        void addRect(const QRectF& rect) {
+            spread(rect, 1.0f);
+        }
+
+        //Takes back an earlier addRect() of the same 'rect'
+        void removeRect(const QRectF& rect) {
+            spread(rect, -1.0f);
+        }
+
+        void addLine(const QLineF& line) {
+            spread(getLineRect(line), 1.0f);
+        }
+
+        void removeLine(const QLineF& line) {
+            spread(getLineRect(line), -1.0f);
+        }
+
+        //Call once items are added or removed, from the GUI thread. Only the
+        //changed cells are converted, the pixmap is uploaded whole.
+        void finish() {
+            if(m_dirtyLeft > m_dirtyRight || m_dirtyTop > m_dirtyBottom) {
+                return;
+            }
+            for(int row = std::max(0, m_dirtyTop); row <= m_dirtyBottom; ++row) {
+                auto* const pixels = reinterpret_cast<QRgb*>(m_image.scanLine(row));
+                const auto* const cells = &m_coverage[static_cast<std::size_t>(row) * m_columns];
+                for(int col = std::max(0, m_dirtyLeft); col <= m_dirtyRight; ++col) {
+                    //Removed items may leave rounding residue below zero
+                    const auto alpha = std::clamp(cells[col] / fullCoverage, 0.0f, 1.0f);
+                    pixels[col] = qRgba(0, 0, 0, static_cast<int>(alpha * 255));
+                }
+            }
+            m_pixmap = QPixmap::fromImage(m_image);
+            m_dirtyLeft = m_dirtyTop = std::numeric_limits<int>::max();
+            m_dirtyRight = m_dirtyBottom = -1;
+        }
+
+        void draw(QPainter* painter) const {
+            painter->drawPixmap(m_rect, m_pixmap, QRectF(m_pixmap.rect()));
+        }
+    };
+
+}
+
+#endif
@@ -5,9 +5,13 @@ namespace gui_qt {
 
     constexpr qreal g_gridRaster = 10;
 
+    //Smallest sheet, the sheet grows with the circuit drawn on it
     constexpr qreal g_logSchWidth = 100;
     constexpr qreal g_logSchHeight = g_logSchWidth / 2;
 
+    //Free space kept around the circuit
+    constexpr qreal g_logSchMargin = 10;
+
     template<typename T>
     constexpr T L2P(T log) {
         return log * g_gridRaster;
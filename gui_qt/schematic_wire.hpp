@@ -0,0 +1,111 @@
+#ifndef SCHEMATIC_WIRE
+#define SCHEMATIC_WIRE
+
+#include <QGraphicsItem>
+#include <QStyleOptionGraphicsItem>
+#include <QPainter>
+#include <QVector>
+#include <QLineF>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <schematic_params.hpp>
+#include <wire_router.hpp>
+
+namespace gui_qt {
+
+    //Routed wires of one net
+    class SchWire : public QGraphicsItem {
+
+        //Segments of a net are kept grouped by square tiles of the grid, a repaint
+        //draws the tiles meeting the exposed rect, each in one drawLines() call
+        static constexpr std::int32_t tileSize = 64;
+
+        struct Tile {
+            QRectF rect;
+            int begin;
+            int end;
+        };
+
+        std::string m_name;
+        QVector<QLineF> m_lines;
+        std::vector<Tile> m_tiles;
+        QRectF m_rect;
+
+        static qreal thick;
+
+        static std::int32_t getTile(std::int32_t coord) {
+            return (coord >= 0) ? coord / tileSize : (coord - tileSize + 1) / tileSize;
+        }
+
+        //Shared by all wires, rebuilt by setThickness()
+        static QPen pen;
+
+        public:
+        static void setThickness(qreal th) {
+            thick = th;
+            pen = QPen(Qt::darkBlue, L2P(thick), Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin);
+        }
+
+        SchWire(const std::string& name, const std::vector<WireSegment>& segments)
+            : m_name(name) {
+            //Segments belong to the tile of their first end
+            std::vector<std::pair<std::pair<std::int32_t, std::int32_t>, std::size_t>> order;
+            order.reserve(segments.size());
+            for(std::size_t i = 0; i < segments.size(); ++i) {
+                const auto& from = segments[i].from;
+                order.emplace_back(std::make_pair(getTile(from.y), getTile(from.x)), i);
+            }
+            std::sort(order.begin(), order.end());
+
+            //Room for the pen, horizontal and vertical lines have empty rects
+            const auto margin = L2P(qreal(1));
+            m_lines.reserve(static_cast<int>(segments.size()));
+            for(std::size_t i = 0; i < order.size(); ++i) {
+                const auto& seg = segments[order[i].second];
+                m_lines.append(QLineF(L2P(qreal(seg.from.x)), L2P(qreal(seg.from.y)),
+                                      L2P(qreal(seg.to.x)), L2P(qreal(seg.to.y))));
+                const auto rect = QRectF(m_lines.back().p1(), m_lines.back().p2()).normalized()
+                    .adjusted(-margin, -margin, margin, margin);
+                if(i == 0 || order[i].first != order[i - 1].first) {
+                    m_tiles.push_back(Tile{ rect, m_lines.size() - 1, m_lines.size() });
+                } else {
+                    m_tiles.back().rect |= rect;
+                    m_tiles.back().end = m_lines.size();
+                }
+                m_rect |= rect;
+            }
+            setFlag(QGraphicsItem::ItemUsesExtendedStyleOption, true);
+        }
+
+        virtual ~SchWire() = default;
+
+        const std::string& getName() const {
+            return m_name;
+        }
+
+        const QVector<QLineF>& getLines() const {
+            return m_lines;
+        }
+
+        virtual QRectF boundingRect() const override {
+            return m_rect;
+        }
+
+        virtual void paint(QPainter *painter,
+                    const QStyleOptionGraphicsItem * opt,
+                    QWidget *) override {
+            painter->setClipRect(opt->exposedRect);
+            painter->setPen(pen);
+            for(const auto& tile : m_tiles) {
+                if(tile.rect.intersects(opt->exposedRect)) {
+                    painter->drawLines(m_lines.constData() + tile.begin, tile.end - tile.begin);
+                }
+            }
+        }
+    };
+
+}
+
+#endif
@@ -0,0 +1,798 @@
+#ifndef WIRE_ROUTER
+#define WIRE_ROUTER
+
+#include <string>
+#include <vector>
+#include <queue>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <limits>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <thread_pool.hpp>
+#include <logger.hpp>
+
+namespace gui_qt {
+
+    //Point of the schematic grid (g_gridRaster), in grid units
+    struct WirePoint {
+        std::int32_t x;
+        std::int32_t y;
+
+        bool operator==(const WirePoint& other) const {
+            return x == other.x && y == other.y;
+        }
+    };
+
+    //Horizontal or vertical
+    struct WireSegment {
+        WirePoint from;
+        WirePoint to;
+    };
+
+    //Inclusive bounds of a symbol, wires do not cross its inside
+    struct WireObstacle {
+        std::int32_t x0;
+        std::int32_t y0;
+        std::int32_t x1;
+        std::int32_t y1;
+    };
+
+    //Manhattan router for the nets of the schematic. Nets are routed in
+    //parallel, each worker takes the next few nets from a shared cursor, so
+    //long nets do not hold back the others. All nets share one occupancy grid
+    //holding the owner of every grid edge. Edges are claimed lock free, wires
+    //of different nets avoid running along each other (they may, at a high
+    //cost, where there is no other way; such edges are counted as overlaps).
+    //
+    //A net is grown like a tree from its first terminal, every further
+    //terminal is joined to the tree by an A* search with bend, crossing and
+    //overlap penalties, limited to a window around the net. Time is bounded:
+    //connections of nets with too large a window or with searches expanding
+    //too many nodes get the cheapest L or Z shaped path instead, nets with
+    //many terminals and nets started after the time budget get a trunk at
+    //the median height with drops to the terminals.
+    class WireRouter {
+        public:
+        struct NetStats {
+            std::size_t terminals;
+            std::int64_t micros;
+            std::size_t expanded;
+            std::size_t overlaps;
+            bool fallback;
+        };
+
+        private:
+        static constexpr std::uint32_t m_free = 0;
+        static constexpr std::uint32_t m_none = std::numeric_limits<std::uint32_t>::max();
+        static constexpr std::int32_t m_margin = 4;
+        static constexpr std::int32_t m_windowMargin = 8;
+        static constexpr std::uint32_t m_bendCost = 2;
+        static constexpr std::uint32_t m_crossCost = 3;
+        static constexpr std::uint32_t m_overlapCost = 24;
+        //Weight of the A* heuristic, trades a little wire length for far fewer expanded nodes
+        static constexpr std::uint32_t m_greed = 2;
+        static constexpr std::size_t m_maxGridTiles = std::size_t(1) << 22;
+        static constexpr std::size_t m_maxWindowCells = std::size_t(1) << 18;
+        static constexpr std::size_t m_maxSearchTerminals = 64;
+        static constexpr std::size_t m_maxExpansions = std::size_t(1) << 16;
+        static constexpr std::size_t m_netsPerTake = 8;
+        static constexpr std::int32_t m_patternSteps = 8;
+        static constexpr std::int32_t m_maxPatternLength = 2048;
+        static constexpr std::size_t m_maxAllocatedTiles = std::size_t(1) << 13;
+
+        //Arrival direction of a search state, index 4 marks a search start
+        struct Dir {
+            std::int32_t dx;
+            std::int32_t dy;
+        };
+        static constexpr Dir m_dirs[] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+        static constexpr std::uint32_t m_dirsCount = 5;
+
+        struct Net {
+            std::string name;
+            std::vector<WirePoint> terminals;
+        };
+
+        //Owners (net index + 1) of the grid edges, edge h of a cell leads to its
+        //right neighbour, edge v to the neighbour below. The grid is split into
+        //tiles allocated on first write, so a sparse schematic costs memory only
+        //where symbols and wires are. Tiles are installed lock free.
+        class OccupancyGrid {
+            static constexpr std::int32_t m_tileBits = 5;
+            static constexpr std::int32_t m_tileSize = 1 << m_tileBits;
+            static constexpr std::int32_t m_tileMask = m_tileSize - 1;
+            static constexpr std::size_t m_tileCells = std::size_t(m_tileSize) * m_tileSize;
+
+            struct Tile {
+                std::atomic<std::uint32_t> h[m_tileCells];
+                std::atomic<std::uint32_t> v[m_tileCells];
+                std::uint32_t pins[m_tileCells];
+                std::uint8_t blocked[m_tileCells];
+
+                Tile() {
+                    for(std::size_t i = 0; i < m_tileCells; ++i) {
+                        h[i].store(m_free, std::memory_order_relaxed);
+                        v[i].store(m_free, std::memory_order_relaxed);
+                        pins[i] = m_free;
+                        blocked[i] = 0;
+                    }
+                }
+            };
+
+            std::int32_t m_x0;
+            std::int32_t m_y0;
+            std::int32_t m_width;
+            std::int32_t m_height;
+            std::int32_t m_tilesX;
+            std::vector<std::atomic<Tile*>> m_tiles;
+            std::atomic<std::size_t> m_allocated;
+
+            OccupancyGrid(const OccupancyGrid&) = delete;
+            OccupancyGrid& operator=(const OccupancyGrid&) = delete;
+
+            std::size_t getTileIndex(std::int32_t x, std::int32_t y) const {
+                return std::size_t((y - m_y0) >> m_tileBits) * m_tilesX + ((x - m_x0) >> m_tileBits);
+            }
+
+            static std::size_t getCell(std::int32_t x, std::int32_t y) {
+                return (std::size_t(y & m_tileMask) << m_tileBits) | std::size_t(x & m_tileMask);
+            }
+
+            //nullptr where nothing was written yet
+            const Tile* findTile(std::int32_t x, std::int32_t y) const {
+                return m_tiles[getTileIndex(x, y)].load(std::memory_order_acquire);
+            }
+
+            //nullptr when m_maxAllocatedTiles are taken, what is written there is not tracked
+            Tile* getTile(std::int32_t x, std::int32_t y) {
+                auto& slot = m_tiles[getTileIndex(x, y)];
+                auto* tile = slot.load(std::memory_order_acquire);
+                if(tile == nullptr) {
+                    if(m_allocated.fetch_add(1, std::memory_order_relaxed) >= m_maxAllocatedTiles) {
+                        return nullptr;
+                    }
+                    auto* created = new Tile();
+                    if(slot.compare_exchange_strong(tile, created, std::memory_order_acq_rel)) {
+                        tile = created;
+                    } else {
+                        delete created;
+                    }
+                }
+                return tile;
+            }
+
+            std::uint32_t getH(std::int32_t x, std::int32_t y) const {
+                const auto* tile = findTile(x, y);
+                return (tile == nullptr) ? m_free : tile->h[getCell(x - m_x0, y - m_y0)].load(std::memory_order_relaxed);
+            }
+
+            std::uint32_t getV(std::int32_t x, std::int32_t y) const {
+                const auto* tile = findTile(x, y);
+                return (tile == nullptr) ? m_free : tile->v[getCell(x - m_x0, y - m_y0)].load(std::memory_order_relaxed);
+            }
+
+            public:
+            OccupancyGrid(std::int32_t x0, std::int32_t y0, std::int32_t width, std::int32_t height)
+                : m_x0(x0), m_y0(y0), m_width(width), m_height(height),
+                m_tilesX((width + m_tileMask) >> m_tileBits),
+                m_tiles(std::size_t(m_tilesX) * ((height + m_tileMask) >> m_tileBits)), m_allocated(0) {
+                for(auto& tile : m_tiles) {
+                    tile.store(nullptr, std::memory_order_relaxed);
+                }
+            }
+
+            virtual ~OccupancyGrid() {
+                for(auto& tile : m_tiles) {
+                    delete tile.load(std::memory_order_relaxed);
+                }
+            }
+
+            //Cells the grid may cover, limited by the size of the tile table
+            static constexpr std::size_t getMaxCells() {
+                return m_maxGridTiles * m_tileCells;
+            }
+
+            bool contains(std::int32_t x, std::int32_t y) const {
+                return x >= m_x0 && y >= m_y0 && x < m_x0 + m_width && y < m_y0 + m_height;
+            }
+
+            std::int32_t getX0() const { return m_x0; }
+            std::int32_t getY0() const { return m_y0; }
+            std::int32_t getX1() const { return m_x0 + m_width - 1; }
+            std::int32_t getY1() const { return m_y0 + m_height - 1; }
+
+            //Owner of the edge from (x, y) one step in 'dir'
+            std::uint32_t getOwner(std::int32_t x, std::int32_t y, const Dir& dir) const {
+                if(dir.dy == 0) {
+                    return getH(std::min(x, x + dir.dx), y);
+                }
+                return getV(x, std::min(y, y + dir.dy));
+            }
+
+            //Foreign wire running across 'dir' through the cell
+            bool isCrossed(std::int32_t x, std::int32_t y, const Dir& dir, std::uint32_t owner) const {
+                auto foreign = [&](std::uint32_t val) {
+                    return val != m_free && val != owner;
+                };
+                if(dir.dy == 0) {
+                    return foreign(getV(x, y)) || (y > m_y0 && foreign(getV(x, y - 1)));
+                }
+                return foreign(getH(x, y)) || (x > m_x0 && foreign(getH(x - 1, y)));
+            }
+
+            //Returns false when the edge already belongs to another net
+            bool claim(std::int32_t x, std::int32_t y, const Dir& dir, std::uint32_t owner) {
+                const auto ex = (dir.dy == 0) ? std::min(x, x + dir.dx) : x;
+                const auto ey = (dir.dy == 0) ? y : std::min(y, y + dir.dy);
+                auto* const tile = getTile(ex, ey);
+                if(tile == nullptr) {
+                    return true;
+                }
+                auto& edge = (dir.dy == 0) ? tile->h[getCell(ex - m_x0, ey - m_y0)] : tile->v[getCell(ex - m_x0, ey - m_y0)];
+                auto expected = m_free;
+                return edge.compare_exchange_strong(expected, owner, std::memory_order_relaxed) || expected == owner;
+            }
+
+            bool isPassable(std::int32_t x, std::int32_t y, std::uint32_t owner) const {
+                const auto* tile = findTile(x, y);
+                if(tile == nullptr) {
+                    return true;
+                }
+                const auto cell = getCell(x - m_x0, y - m_y0);
+                return tile->blocked[cell] == 0 && (tile->pins[cell] == m_free || tile->pins[cell] == owner);
+            }
+
+            //Not synchronized, called before routing starts
+            void block(const WireObstacle& obstacle) {
+                for(auto y = std::max(obstacle.y0 + 1, m_y0); y < std::min(obstacle.y1, m_y0 + m_height); ++y) {
+                    for(auto x = std::max(obstacle.x0 + 1, m_x0); x < std::min(obstacle.x1, m_x0 + m_width); ++x) {
+                        if(auto* const tile = getTile(x, y)) {
+                            tile->blocked[getCell(x - m_x0, y - m_y0)] = 1;
+                        }
+                    }
+                }
+            }
+
+            void setPin(const WirePoint& point, std::uint32_t owner) {
+                if(auto* const tile = getTile(point.x, point.y)) {
+                    auto& pin = tile->pins[getCell(point.x - m_x0, point.y - m_y0)];
+                    pin = (pin == m_free || pin == owner) ? owner : m_none;
+                }
+            }
+        };
+
+        //Search state of one worker, reused by all nets it routes. Arrays are
+        //indexed by window cell (and arrival direction), stamps avoid clearing.
+        struct SearchBuffers {
+            std::vector<std::uint32_t> cost;
+            std::vector<std::uint32_t> parent;
+            std::vector<std::uint32_t> stamp;
+            std::vector<std::uint32_t> tree;
+            std::uint32_t searchGen = 0;
+            std::uint32_t treeGen = 0;
+
+            void reserve(std::size_t cells) {
+                if(tree.size() < cells) {
+                    cost.assign(cells * m_dirsCount, 0);
+                    parent.assign(cells * m_dirsCount, 0);
+                    stamp.assign(cells * m_dirsCount, 0);
+                    tree.assign(cells, 0);
+                    searchGen = 0;
+                    treeGen = 0;
+                }
+            }
+        };
+
+        //Part of the grid a net is routed in
+        struct Window {
+            std::int32_t x0;
+            std::int32_t y0;
+            std::int32_t width;
+            std::int32_t height;
+
+            bool contains(std::int32_t x, std::int32_t y) const {
+                return x >= x0 && y >= y0 && x < x0 + width && y < y0 + height;
+            }
+
+            std::uint32_t getIndex(std::int32_t x, std::int32_t y) const {
+                return std::uint32_t(y - y0) * width + (x - x0);
+            }
+
+            WirePoint getPoint(std::uint32_t idx) const {
+                return { x0 + std::int32_t(idx % width), y0 + std::int32_t(idx / width) };
+            }
+        };
+
+        std::size_t m_threads;
+        std::chrono::milliseconds m_timeBudget;
+        std::vector<WireObstacle> m_obstacles;
+        //Wires of nets not routed this time, kept where they are
+        std::vector<WireSegment> m_fixedWires;
+        std::vector<Net> m_nets;
+        std::vector<std::vector<WireSegment>> m_wires;
+        std::vector<NetStats> m_stats;
+        std::unique_ptr<OccupancyGrid> m_grid;
+        bool m_hasGrid;
+
+        //Appends the path as segments, merging straight runs
+        static void appendPath(const std::vector<WirePoint>& path, std::vector<WireSegment>& wires) {
+            if(path.size() < 2) {
+                return;
+            }
+            auto from = path.front();
+            for(std::size_t i = 1; i + 1 < path.size(); ++i) {
+                const bool horizontal = (path[i - 1].y == path[i].y);
+                if(horizontal != (path[i].y == path[i + 1].y)) {
+                    wires.emplace_back(WireSegment{ from, path[i] });
+                    from = path[i];
+                }
+            }
+            wires.emplace_back(WireSegment{ from, path.back() });
+        }
+
+        static std::int32_t getSign(std::int32_t val) {
+            return (val > 0) - (val < 0);
+        }
+
+        static std::int32_t getDistance(const WirePoint& a, const WirePoint& b) {
+            return std::abs(a.x - b.x) + std::abs(a.y - b.y);
+        }
+
+        //Claims (or only checks) the edges of a straight segment, at most 'budget' of them
+        void claimSegment(const WireSegment& seg, std::uint32_t owner, bool claim, std::size_t& budget, NetStats& stats) {
+            if(!m_grid || !m_grid->contains(seg.from.x, seg.from.y) || !m_grid->contains(seg.to.x, seg.to.y)) {
+                return;
+            }
+            const Dir dir{ getSign(seg.to.x - seg.from.x), getSign(seg.to.y - seg.from.y) };
+            for(auto p = seg.from; !(p == seg.to) && budget > 0; p.x += dir.dx, p.y += dir.dy, --budget) {
+                const auto edge = m_grid->getOwner(p.x, p.y, dir);
+                if(claim ? !m_grid->claim(p.x, p.y, dir, owner) : (edge != m_free && edge != owner)) {
+                    ++stats.overlaps;
+                }
+            }
+        }
+
+        //Horizontal trunk at the median terminal height with a drop from every terminal
+        void routeTrunk(std::size_t netIdx, bool check, NetStats& stats) {
+            const auto& terminals = m_nets[netIdx].terminals;
+            auto& wires = m_wires[netIdx];
+            std::vector<std::int32_t> ys;
+            ys.reserve(terminals.size());
+            auto minX = terminals.front().x;
+            auto maxX = terminals.front().x;
+            for(const auto& term : terminals) {
+                ys.emplace_back(term.y);
+                minX = std::min(minX, term.x);
+                maxX = std::max(maxX, term.x);
+            }
+            std::nth_element(ys.begin(), ys.begin() + ys.size() / 2, ys.end());
+            const auto trunkY = ys[ys.size() / 2];
+
+            if(minX != maxX) {
+                wires.emplace_back(WireSegment{ { minX, trunkY }, { maxX, trunkY } });
+            }
+            for(const auto& term : terminals) {
+                if(term.y != trunkY) {
+                    wires.emplace_back(WireSegment{ term, { term.x, trunkY } });
+                }
+            }
+
+            //Trunks span the widest nets, routed last, so their edges are only checked
+            auto budget = check ? m_maxWindowCells : 0;
+            for(const auto& seg : wires) {
+                claimSegment(seg, std::uint32_t(netIdx + 1), false, budget, stats);
+            }
+        }
+
+        //Cheapest of the L and Z shaped paths from 'from' to 'to', taken where searching is too expensive
+        void routePattern(const WirePoint& from, const WirePoint& to, std::uint32_t owner, std::vector<WirePoint>& path) const {
+            auto walk = [&](const WirePoint (&corners)[4], std::vector<WirePoint>* cells) {
+                std::uint64_t cost = 0;
+                auto p = corners[0];
+                for(const auto& corner : corners) {
+                    const Dir dir{ getSign(corner.x - p.x), getSign(corner.y - p.y) };
+                    cost += (p == corner) ? 0 : m_bendCost;
+                    for(; !(p == corner); p.x += dir.dx, p.y += dir.dy) {
+                        if(cells != nullptr) {
+                            cells->emplace_back(p);
+                            continue;
+                        }
+                        cost += 1;
+                        const auto nx = p.x + dir.dx;
+                        const auto ny = p.y + dir.dy;
+                        if(m_grid && m_grid->contains(p.x, p.y) && m_grid->contains(nx, ny)) {
+                            const auto edge = m_grid->getOwner(p.x, p.y, dir);
+                            cost += (edge != m_free && edge != owner) ? m_overlapCost : 0;
+                            cost += m_grid->isPassable(nx, ny, owner) ? 0 : m_overlapCost;
+                            cost += m_grid->isCrossed(nx, ny, dir, owner) ? m_crossCost : 0;
+                        }
+                    }
+                }
+                if(cells != nullptr) {
+                    cells->emplace_back(p);
+                }
+                return cost;
+            };
+
+            WirePoint best[4] = { from, { to.x, from.y }, to, to };
+            auto bestCost = std::numeric_limits<std::uint64_t>::max();
+            const auto steps = (getDistance(from, to) > m_maxPatternLength) ? -1 : m_patternSteps;
+            for(std::int32_t step = 0; step <= steps; ++step) {
+                const auto midX = from.x + (to.x - from.x) * step / m_patternSteps;
+                const auto midY = from.y + (to.y - from.y) * step / m_patternSteps;
+                const WirePoint candidates[2][4] = { { from, { midX, from.y }, { midX, to.y }, to },
+                                                     { from, { from.x, midY }, { to.x, midY }, to } };
+                for(const auto& corners : candidates) {
+                    const auto cost = walk(corners, nullptr);
+                    if(cost < bestCost) {
+                        bestCost = cost;
+                        std::copy(std::begin(corners), std::end(corners), best);
+                    }
+                }
+            }
+            path.clear();
+            walk(best, &path);
+        }
+
+        //A* from 'start' to any cell of the tree, the path is returned from the tree to 'start'
+        bool search(const Window& win, const WirePoint& start, const WireObstacle& treeBox,
+                    std::uint32_t owner, SearchBuffers& buf, std::vector<WirePoint>& path, NetStats& stats) {
+            typedef std::pair<std::uint32_t, std::uint32_t> TEntry;
+            std::priority_queue<TEntry, std::vector<TEntry>, std::greater<TEntry>> open;
+
+            if(++buf.searchGen == 0) {
+                std::fill(buf.stamp.begin(), buf.stamp.end(), 0);
+                buf.searchGen = 1;
+            }
+            auto heuristic = [&](std::int32_t x, std::int32_t y) {
+                const auto dx = std::max({ treeBox.x0 - x, 0, x - treeBox.x1 });
+                const auto dy = std::max({ treeBox.y0 - y, 0, y - treeBox.y1 });
+                return std::uint32_t(dx + dy) * m_greed;
+            };
+
+            const auto startState = win.getIndex(start.x, start.y) * m_dirsCount + 4;
+            buf.stamp[startState] = buf.searchGen;
+            buf.cost[startState] = 0;
+            buf.parent[startState] = m_none;
+            open.emplace(heuristic(start.x, start.y), startState);
+
+            std::size_t expanded = 0;
+            while(!open.empty() && expanded < m_maxExpansions) {
+                const auto [f, state] = open.top();
+                open.pop();
+                const auto cell = state / m_dirsCount;
+                const auto arrival = state % m_dirsCount;
+                const auto cost = buf.cost[state];
+                const auto p = win.getPoint(cell);
+                if(f != cost + heuristic(p.x, p.y)) {
+                    continue;
+                }
+                ++expanded;
+
+                if(buf.tree[cell] == buf.treeGen) {
+                    path.clear();
+                    for(auto s = state; s != m_none; s = buf.parent[s]) {
+                        path.emplace_back(win.getPoint(s / m_dirsCount));
+                    }
+                    stats.expanded += expanded;
+                    return true;
+                }
+
+                for(std::uint32_t d = 0; d < 4; ++d) {
+                    const auto& dir = m_dirs[d];
+                    const auto nx = p.x + dir.dx;
+                    const auto ny = p.y + dir.dy;
+                    if(!win.contains(nx, ny) || !m_grid->isPassable(nx, ny, owner)) {
+                        continue;
+                    }
+                    auto next = cost + 1;
+                    const auto edge = m_grid->getOwner(p.x, p.y, dir);
+                    if(edge != m_free && edge != owner) {
+                        next += m_overlapCost;
+                    }
+                    if(arrival != 4 && arrival != d) {
+                        next += m_bendCost;
+                    }
+                    if(m_grid->isCrossed(nx, ny, dir, owner)) {
+                        next += m_crossCost;
+                    }
+
+                    const auto nextState = win.getIndex(nx, ny) * m_dirsCount + d;
+                    if(buf.stamp[nextState] != buf.searchGen || next < buf.cost[nextState]) {
+                        buf.stamp[nextState] = buf.searchGen;
+                        buf.cost[nextState] = next;
+                        buf.parent[nextState] = state;
+                        open.emplace(next + heuristic(nx, ny), nextState);
+                    }
+                }
+            }
+            stats.expanded += expanded;
+            return false;
+        }
+
+        //Joins the terminals one by one, the one closest to those joined so far first.
+        //Without a window every connection is pattern routed.
+        void routeTree(std::size_t netIdx, const Window* win, SearchBuffers& buf, NetStats& stats) {
+            const auto owner = std::uint32_t(netIdx + 1);
+            auto terminals = m_nets[netIdx].terminals;
+            auto& wires = m_wires[netIdx];
+            auto budget = m_maxWindowCells;
+
+            WireObstacle treeBox{ terminals.front().x, terminals.front().y, terminals.front().x, terminals.front().y };
+            auto addToTree = [&](const WirePoint& p) {
+                buf.tree[win->getIndex(p.x, p.y)] = buf.treeGen;
+                treeBox = { std::min(treeBox.x0, p.x), std::min(treeBox.y0, p.y), std::max(treeBox.x1, p.x), std::max(treeBox.y1, p.y) };
+            };
+            if(win != nullptr) {
+                if(++buf.treeGen == 0) {
+                    std::fill(buf.tree.begin(), buf.tree.end(), 0);
+                    buf.treeGen = 1;
+                }
+                addToTree(terminals.front());
+            }
+
+            std::vector<WirePoint> joined(1, terminals.front());
+            std::vector<WirePoint> path;
+            for(std::size_t done = 1; done < terminals.size(); ++done) {
+                auto best = done;
+                auto target = joined.front();
+                auto bestDist = std::numeric_limits<std::int32_t>::max();
+                for(auto i = done; i < terminals.size(); ++i) {
+                    for(const auto& j : joined) {
+                        const auto dist = getDistance(terminals[i], j);
+                        if(dist < bestDist) {
+                            bestDist = dist;
+                            best = i;
+                            target = j;
+                        }
+                    }
+                }
+                std::swap(terminals[done], terminals[best]);
+                const auto term = terminals[done];
+                joined.emplace_back(term);
+                if(win != nullptr && buf.tree[win->getIndex(term.x, term.y)] == buf.treeGen) {
+                    continue;
+                }
+
+                if(win == nullptr || !search(*win, term, treeBox, owner, buf, path, stats)) {
+                    stats.fallback = true;
+                    routePattern(term, target, owner, path);
+                }
+
+                const auto first = wires.size();
+                appendPath(path, wires);
+                for(auto i = first; i < wires.size(); ++i) {
+                    claimSegment(wires[i], owner, true, budget, stats);
+                }
+                if(win != nullptr) {
+                    for(const auto& p : path) {
+                        addToTree(p);
+                    }
+                }
+            }
+        }
+
+        void routeNet(std::size_t netIdx, bool late, SearchBuffers& buf) {
+            const auto begin = std::chrono::steady_clock::now();
+            const auto& terminals = m_nets[netIdx].terminals;
+            auto& stats = m_stats[netIdx];
+            stats = NetStats{ terminals.size(), 0, 0, 0, false };
+
+            if(terminals.size() >= 2) {
+                auto box = WireObstacle{ terminals.front().x, terminals.front().y, terminals.front().x, terminals.front().y };
+                for(const auto& term : terminals) {
+                    box = { std::min(box.x0, term.x), std::min(box.y0, term.y), std::max(box.x1, term.x), std::max(box.y1, term.y) };
+                }
+
+                Window win{ 0, 0, 0, 0 };
+                if(m_grid) {
+                    const auto margin = m_windowMargin + std::max(box.x1 - box.x0, box.y1 - box.y0) / 4;
+                    const auto x0 = std::max(box.x0 - margin, m_grid->getX0());
+                    const auto y0 = std::max(box.y0 - margin, m_grid->getY0());
+                    const auto x1 = std::min(box.x1 + margin, m_grid->getX1());
+                    const auto y1 = std::min(box.y1 + margin, m_grid->getY1());
+                    win = { x0, y0, x1 - x0 + 1, y1 - y0 + 1 };
+                }
+
+                if(late || !m_grid || terminals.size() > m_maxSearchTerminals) {
+                    stats.fallback = true;
+                    routeTrunk(netIdx, !late, stats);
+                } else if(std::size_t(win.width) * win.height > m_maxWindowCells) {
+                    routeTree(netIdx, nullptr, buf, stats);
+                } else {
+                    buf.reserve(std::size_t(win.width) * win.height);
+                    routeTree(netIdx, &win, buf, stats);
+                }
+            }
+
+            stats.micros = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin).count();
+        }
+
+        //Occupancy grid covering all terminals and obstacles, none when it would be too large
+        void createGrid() {
+            m_grid.reset();
+            m_hasGrid = false;
+            bool any = false;
+            WireObstacle box{ 0, 0, 0, 0 };
+            auto extend = [&](std::int32_t x0, std::int32_t y0, std::int32_t x1, std::int32_t y1) {
+                box = any ? WireObstacle{ std::min(box.x0, x0), std::min(box.y0, y0), std::max(box.x1, x1), std::max(box.y1, y1) }
+                          : WireObstacle{ x0, y0, x1, y1 };
+                any = true;
+            };
+            for(const auto& obstacle : m_obstacles) {
+                extend(obstacle.x0, obstacle.y0, obstacle.x1, obstacle.y1);
+            }
+            for(const auto& net : m_nets) {
+                for(const auto& term : net.terminals) {
+                    extend(term.x, term.y, term.x, term.y);
+                }
+            }
+
+            const auto width = std::int64_t(box.x1) - box.x0 + 1 + 2 * m_margin;
+            const auto height = std::int64_t(box.y1) - box.y0 + 1 + 2 * m_margin;
+            if(!any || width * height > std::int64_t(OccupancyGrid::getMaxCells())) {
+                return;
+            }
+
+            m_grid = std::make_unique<OccupancyGrid>(box.x0 - m_margin, box.y0 - m_margin, std::int32_t(width), std::int32_t(height));
+            m_hasGrid = true;
+            for(const auto& obstacle : m_obstacles) {
+                m_grid->block(obstacle);
+            }
+            //Owned by no net, so routed wires cross them at a cost and run along them only at a high one
+            for(const auto& seg : m_fixedWires) {
+                const Dir dir{ getSign(seg.to.x - seg.from.x), getSign(seg.to.y - seg.from.y) };
+                for(auto p = seg.from; !(p == seg.to); p.x += dir.dx, p.y += dir.dy) {
+                    if(m_grid->contains(p.x, p.y) && m_grid->contains(p.x + dir.dx, p.y + dir.dy)) {
+                        m_grid->claim(p.x, p.y, dir, m_none);
+                    }
+                }
+            }
+            for(std::size_t netIdx = 0; netIdx < m_nets.size(); ++netIdx) {
+                for(const auto& term : m_nets[netIdx].terminals) {
+                    m_grid->setPin(term, std::uint32_t(netIdx + 1));
+                }
+            }
+        }
+
+        void logStats(std::int64_t totalMs) const {
+            if constexpr(!logging::isEnabled(logging::Level::Info)) {
+                return;
+            }
+
+            std::size_t fallbacks = 0;
+            std::size_t overlaps = 0;
+            std::size_t slowest = 0;
+            std::vector<std::int64_t> micros;
+            micros.reserve(m_stats.size());
+            for(std::size_t netIdx = 0; netIdx < m_stats.size(); ++netIdx) {
+                const auto& stats = m_stats[netIdx];
+                fallbacks += stats.fallback ? 1 : 0;
+                overlaps += stats.overlaps;
+                micros.emplace_back(stats.micros);
+                if(stats.micros > m_stats[slowest].micros) {
+                    slowest = netIdx;
+                }
+            }
+            if(micros.empty()) {
+                return;
+            }
+            std::sort(micros.begin(), micros.end());
+
+            logging::info("Routed ", m_nets.size(), " nets in ", totalMs, " ms on ", m_threads, " threads",
+                          m_hasGrid ? "" : " without occupancy grid", ", fallbacks: ", fallbacks, ", overlaps: ", overlaps,
+                          ", per net median/p99/max: ", micros[micros.size() / 2], "/",
+                          micros[micros.size() * 99 / 100], "/", micros.back(), " us, slowest '",
+                          m_nets[slowest].name, "'");
+        }
+
+        public:
+        WireRouter(std::size_t threads = task::ThreadPool::getDefaultSize(),
+                   std::chrono::milliseconds timeBudget = std::chrono::milliseconds(2000))
+            : m_threads(std::max<std::size_t>(threads, 1)), m_timeBudget(timeBudget), m_hasGrid(false) {
+        }
+
+        virtual ~WireRouter() = default;
+
+        void addObstacle(const WireObstacle& obstacle) {
+            m_obstacles.emplace_back(obstacle);
+        }
+
+        //Routed earlier and kept, the nets routed now avoid it like each other's wires
+        void addFixedWire(const WireSegment& segment) {
+            m_fixedWires.emplace_back(segment);
+        }
+
+        //Returns the index of the net, terminals at the same point are merged
+        std::size_t addNet(const std::string& name, std::vector<WirePoint> terminals) {
+            std::sort(terminals.begin(), terminals.end(), [](const auto& a, const auto& b) {
+                    return (a.x != b.x) ? a.x < b.x : a.y < b.y;
+                    });
+            terminals.erase(std::unique(terminals.begin(), terminals.end()), terminals.end());
+            m_nets.emplace_back(Net{ name, std::move(terminals) });
+            return m_nets.size() - 1;
+        }
+
+        void run() {
+            const auto begin = std::chrono::steady_clock::now();
+            m_wires.assign(m_nets.size(), std::vector<WireSegment>());
+            m_stats.assign(m_nets.size(), NetStats{ 0, 0, 0, 0, false });
+            createGrid();
+
+            //Short nets first, they have the fewest ways around others
+            std::vector<std::size_t> order(m_nets.size());
+            std::vector<std::int64_t> spans(m_nets.size(), 0);
+            for(std::size_t netIdx = 0; netIdx < m_nets.size(); ++netIdx) {
+                order[netIdx] = netIdx;
+                const auto& terminals = m_nets[netIdx].terminals;
+                if(terminals.size() < 2) {
+                    continue;
+                }
+                const auto [minX, maxX] = std::minmax_element(terminals.begin(), terminals.end(), [](const auto& a, const auto& b) { return a.x < b.x; });
+                const auto [minY, maxY] = std::minmax_element(terminals.begin(), terminals.end(), [](const auto& a, const auto& b) { return a.y < b.y; });
+                spans[netIdx] = std::int64_t(maxX->x - minX->x) + (maxY->y - minY->y);
+            }
+            std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+                    return spans[a] < spans[b];
+                    });
+
+            const auto deadline = begin + m_timeBudget;
+            std::atomic<std::size_t> cursor(0);
+            auto work = [&]() {
+                SearchBuffers buf;
+                while(true) {
+                    const auto first = cursor.fetch_add(m_netsPerTake);
+                    if(first >= order.size()) {
+                        return;
+                    }
+                    const auto last = std::min(first + m_netsPerTake, order.size());
+                    const bool late = std::chrono::steady_clock::now() > deadline;
+                    for(auto i = first; i < last; ++i) {
+                        routeNet(order[i], late, buf);
+                    }
+                }
+            };
+
+            const auto threads = std::min(m_threads, std::max<std::size_t>(order.size() / m_netsPerTake, 1));
+            if(threads == 1) {
+                work();
+            } else {
+                task::ThreadPool pool(threads);
+                std::vector<std::future<void>> results;
+                for(std::size_t i = 0; i < threads; ++i) {
+                    results.emplace_back(pool.submit(work));
+                }
+                for(auto& res : results) {
+                    res.get();
+                }
+            }
+            m_grid.reset();
+
+            logStats(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin).count());
+        }
+
+        std::size_t getNetsCount() const {
+            return m_nets.size();
+        }
+
+        const std::string& getNetName(std::size_t netIdx) const {
+            return m_nets[netIdx].name;
+        }
+
+        //Valid after run()
+        const std::vector<WireSegment>& getWires(std::size_t netIdx) const {
+            return m_wires[netIdx];
+        }
+
+        //Valid after run(), indexed as the nets
+        const std::vector<NetStats>& getStats() const {
+            return m_stats;
+        }
+
+    };
+}
+
+#endif
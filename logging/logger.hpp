@@ -0,0 +1,114 @@
+#ifndef LOGGER
+#define LOGGER
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <mutex>
+
+namespace logging {
+
+    enum class Level {
+        Error,
+        Info,
+        Debug
+    };
+
+    //Compile time log level, selected by LOGMODE in spice_visualizer.pro
+#if defined(_SILENT)
+    constexpr Level g_logLevel = Level::Error;
+#elif defined(_VERBOSE)
+    constexpr Level g_logLevel = Level::Debug;
+#else
+    constexpr Level g_logLevel = Level::Info;
+#endif
+
+    constexpr bool isEnabled(Level level) {
+        return static_cast<int>(level) <= static_cast<int>(g_logLevel);
+    }
+
+    //Thread safe buffered sink. Messages are collected in memory and written
+    //out in large blocks. Errors go straight to the error stream, after
+    //whatever was buffered so far.
+    class Sink {
+        static constexpr std::size_t m_flushThreshold = 64 * 1024;
+
+        std::mutex m_mtx;
+        std::string m_buffer;
+        std::ostream& m_os;
+        std::ostream& m_errOs;
+
+        Sink(std::ostream& os, std::ostream& errOs)
+            : m_os(os), m_errOs(errOs) {
+            m_buffer.reserve(m_flushThreshold * 2);
+        }
+
+        void flushUnlocked() {
+            m_os.write(m_buffer.data(), m_buffer.size());
+            m_os.flush();
+            m_buffer.clear();
+        }
+
+        public:
+        virtual ~Sink() {
+            flush();
+        }
+
+        static Sink& instance() {
+            static Sink sink(std::cout, std::cerr);
+            return sink;
+        }
+
+        void write(Level level, const std::string& msg) {
+            std::unique_lock<std::mutex> lck(m_mtx);
+            if(level == Level::Error) {
+                flushUnlocked();
+                m_errOs << msg << std::endl;
+                return;
+            }
+
+            m_buffer.append(msg);
+            m_buffer.push_back('\n');
+            if(m_buffer.size() >= m_flushThreshold) {
+                flushUnlocked();
+            }
+        }
+
+        void flush() {
+            std::unique_lock<std::mutex> lck(m_mtx);
+            flushUnlocked();
+        }
+    };
+
+    template<Level level, typename... TArgs>
+    void log(const TArgs&... args) {
+        if constexpr(isEnabled(level)) {
+            std::ostringstream os;
+            (os << ... << args);
+            Sink::instance().write(level, os.str());
+        }
+    }
+
+    template<typename... TArgs>
+    void error(const TArgs&... args) {
+        log<Level::Error>(args...);
+    }
+
+    template<typename... TArgs>
+    void info(const TArgs&... args) {
+        log<Level::Info>(args...);
+    }
+
+    template<typename... TArgs>
+    void debug(const TArgs&... args) {
+        log<Level::Debug>(args...);
+    }
+
+    inline void flush() {
+        if constexpr(isEnabled(Level::Info)) {
+            Sink::instance().flush();
+        }
+    }
+}
+
+#endif
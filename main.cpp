@@ -3,6 +3,8 @@
 #include <gui_schematic_qt.hpp>
 #include <gui_progress_qt.hpp>
 #include <processor.hpp>
+#include <batch_processor.hpp>
+#include <version.hpp>
 
 namespace {
 
@@ -20,7 +22,7 @@ namespace {
         virtual ~App() = default;
 
         static const std::string& getVersion() {
-            static const std::string ver = "1.0";
+            static const std::string ver = app::g_version;
             return ver;
         }
 
@@ -28,7 +30,10 @@ namespace {
             try {
                 std::setlocale(LC_NUMERIC, "C");
 
-                const std::string filename = (m_argc > 1) ? m_argv[1] : "<empty>";
+                //spice_visualizer [--watch] <netlist>
+                const bool watch = (m_argc > 2) && std::string(m_argv[1]) == "--watch";
+                const int fileArg = watch ? 2 : 1;
+                const std::string filename = (m_argc > fileArg) ? m_argv[fileArg] : "<empty>";
 
                 m_schematic.reset(new gui::GuiSchematicQt());
                 //gui::GuiSchematicInterfaceExt* pSchematicExt = m_schematic.get();
@@ -38,9 +43,51 @@ namespace {
 
                 circuit::Processor processor;
                 auto* const procThread = processor.getThreadManagerInterface();
-                procThread->start(filename, m_schematic.get(), m_progress.get());
+                m_schematic->setLevelListener([procThread]() { procThread->wake(); });
+                procThread->start(filename, watch, m_schematic.get(), m_progress.get());
 
-                return m_qtApp->exec();
+                const auto result = m_qtApp->exec();
+                m_schematic->setLevelListener(nullptr);
+                return result;
+            } catch(const std::exception& e) {
+                std::cerr << "\033[0;31mException raised:" << std::endl;
+                std::cerr << e.what() << "\033[0m" << std::endl;
+                return EXIT_FAILURE;
+            } catch(...) {
+                std::cerr << "\033[0;31mUnknown exception! Something really bad happened\033[0m"
+                    << std::endl;
+                return EXIT_FAILURE;
+            }
+            return 0;
+        }
+    };
+
+    //Headless mode: spice_visualizer --batch <out_dir> <netlist>...
+    class BatchApp {
+        int m_argc;
+        char** m_argv;
+
+        public:
+        BatchApp(int argc, char** argv)
+            : m_argc(argc), m_argv(argv) {}
+
+        virtual ~BatchApp() = default;
+
+        static bool isRequested(int argc, char** argv) {
+            return argc > 1 && std::string(argv[1]) == "--batch";
+        }
+
+        int run() {
+            try {
+                std::setlocale(LC_NUMERIC, "C");
+
+                if(m_argc < 4) {
+                    throw std::runtime_error("Usage: spice_visualizer --batch <out_dir> <netlist>...");
+                }
+
+                const std::vector<std::string> filenames(m_argv + 3, m_argv + m_argc);
+                circuit::BatchProcessor batch(m_argv[2]);
+                return (batch.run(filenames) == 0) ? 0 : EXIT_FAILURE;
             } catch(const std::exception& e) {
                 std::cerr << "\033[0;31mException raised:" << std::endl;
                 std::cerr << e.what() << "\033[0m" << std::endl;
@@ -56,6 +103,11 @@ namespace {
 }
 
 int main(int argc, char** argv) {
+    if(BatchApp::isRequested(argc, argv)) {
+        BatchApp app(argc, argv);
+        return app.run();
+    }
+
     QApplication qtApp(argc, argv);
     App app(argc, argv, &qtApp);
     return app.run();
@@ -0,0 +1,94 @@
+#ifndef LIBRARY_CACHE
+#define LIBRARY_CACHE
+
+#include <string>
+#include <memory>
+#include <mutex>
+#include <future>
+#include <unordered_map>
+#include <cstdint>
+#include <stdexcept>
+#include <netlist_library.hpp>
+#include <file_utils.hpp>
+
+namespace parsers {
+
+    //Files included so far by any netlist of the process, so shared model
+    //libraries are parsed once per batch or session. Entries are checked
+    //against size and modification time of their file on every lookup,
+    //modified files are parsed again. Failed parses are not kept, the next
+    //lookup tries again.
+    template<typename TParser>
+    class LibraryCache {
+        typedef std::shared_ptr<const NetlistLibrary> TLibrary;
+
+        struct Entry {
+            file_reader::FileStamp stamp;
+            std::shared_future<TLibrary> library;
+            std::uint64_t parseId;
+        };
+
+        std::mutex m_mtx;
+        std::unordered_map<std::string, Entry> m_entries;
+        std::uint64_t m_nextParseId;
+
+        LibraryCache()
+            : m_nextParseId(0) {}
+
+        public:
+        virtual ~LibraryCache() = default;
+
+        static LibraryCache& instance() {
+            static LibraryCache cache;
+            return cache;
+        }
+
+        //Concurrent lookups of a file not parsed yet parse it once, the others wait for the result
+        TLibrary get(const std::string& filename, const TParser& parser) {
+            const auto stamp = file_reader::getFileStamp(filename);
+            if(!stamp.exists) {
+                throw std::runtime_error(std::string("File open error '") + filename + std::string("'"));
+            }
+
+            std::promise<TLibrary> promise;
+            std::shared_future<TLibrary> library;
+            bool parse = false;
+            std::uint64_t parseId = 0;
+            {
+                std::unique_lock<std::mutex> lck(m_mtx);
+                auto it = m_entries.find(filename);
+                if(it != m_entries.end() && it->second.stamp == stamp) {
+                    library = it->second.library;
+                } else {
+                    library = promise.get_future().share();
+                    parseId = m_nextParseId++;
+                    m_entries[filename] = Entry{ stamp, library, parseId };
+                    parse = true;
+                }
+            }
+
+            if(parse) {
+                try {
+                    promise.set_value(std::make_shared<const NetlistLibrary>(filename, parser));
+                } catch(...) {
+                    promise.set_exception(std::current_exception());
+
+                    //Unless a newer parse of the file replaced it meanwhile
+                    std::unique_lock<std::mutex> lck(m_mtx);
+                    auto it = m_entries.find(filename);
+                    if(it != m_entries.end() && it->second.parseId == parseId) {
+                        m_entries.erase(it);
+                    }
+                }
+            }
+            return library.get();
+        }
+
+        void clear() {
+            std::unique_lock<std::mutex> lck(m_mtx);
+            m_entries.clear();
+        }
+    };
+}
+
+#endif
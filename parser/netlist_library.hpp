@@ -0,0 +1,109 @@
+#ifndef NETLIST_LIBRARY
+#define NETLIST_LIBRARY
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+#include <utility>
+#include <stdexcept>
+#include <parser_interface.hpp>
+#include <tokenizer.hpp>
+#include <mapped_file.hpp>
+
+namespace parsers {
+
+    //File pulled in by .include or .lib. Its lines are classified once by the
+    //parser and committed to every parser including the file, exactly like
+    //chunks of the parallel reader. Named library sections (.lib entry ... .endl)
+    //are kept apart, the rest of the file forms the unnamed section.
+    class NetlistLibrary {
+        typedef std::unique_ptr<ParserInterface::Chunk> TChunk;
+
+        std::string m_filename;
+        std::unique_ptr<file_reader::MappedFile> m_file;
+        std::string m_text;
+        std::vector<std::pair<std::string, TChunk>> m_sections;
+
+        NetlistLibrary(const NetlistLibrary&) = delete;
+        NetlistLibrary& operator=(const NetlistLibrary&) = delete;
+
+        //Classified lines point into the file, so it stays mapped (or read) as long as the library lives
+        std::string_view readFile() {
+            m_file = std::make_unique<file_reader::MappedFile>(m_filename);
+            if(m_file->isMapped()) {
+                return m_file->getData();
+            }
+
+            std::ifstream ifs(m_filename, std::ios::binary);
+            if(!ifs.is_open()) {
+                throw std::runtime_error(std::string("File open error '") + m_filename + std::string("'"));
+            }
+            m_text.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+            return m_text;
+        }
+
+        ParserInterface::Chunk& getSection(std::string_view entry, const ParserInterface& parser) {
+            for(auto& section : m_sections) {
+                if(equalsNoCase(section.first, entry)) {
+                    return *section.second;
+                }
+            }
+            m_sections.emplace_back(std::string(entry), parser.createChunk());
+            return *m_sections.back().second;
+        }
+
+        public:
+        NetlistLibrary(const std::string& filename, const ParserInterface& parser)
+            : m_filename(filename) {
+            auto data = readFile();
+            Tokenizer tokenizer;
+            auto* section = &getSection(std::string_view(), parser);
+
+            while(!data.empty()) {
+                const auto end = std::min(data.find('\n'), data.size());
+                auto line = data.substr(0, end);
+                if(!line.empty() && line.back() == 0x0D) {
+                    line.remove_suffix(1);
+                }
+                data.remove_prefix(std::min(end + 1, data.size()));
+
+                //Section boundaries are the only lines not left to the parser
+                const auto first = line.find_first_not_of(" \t");
+                if(first != std::string_view::npos && line[first] == '.') {
+                    const auto& tokens = tokenizer.tokenize(line);
+                    if(tokens.size() == 2 && equalsNoCase(tokens[0], ".lib")) {
+                        section = &getSection(tokens[1], parser);
+                        continue;
+                    } else if(equalsNoCase(tokens[0], ".endl")) {
+                        section = &getSection(std::string_view(), parser);
+                        continue;
+                    }
+                }
+                parser.classifyLine(line, *section);
+            }
+        }
+
+        virtual ~NetlistLibrary() = default;
+
+        const std::string& getFilename() const {
+            return m_filename;
+        }
+
+        //Empty 'entry' selects the lines outside of named sections,
+        //nullptr is returned when the file has no such section
+        const ParserInterface::Chunk* getSection(std::string_view entry) const {
+            for(const auto& section : m_sections) {
+                if(equalsNoCase(section.first, entry)) {
+                    return section.second.get();
+                }
+            }
+            return nullptr;
+        }
+    };
+}
+
+#endif
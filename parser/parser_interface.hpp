@@ -1,11 +1,28 @@
 #ifndef PARSER_INTERFACE
 #define PARSER_INTERFACE
 
+#include <string_view>
+#include <memory>
+
 namespace parsers {
 
     class ParserInterface {
         public:
-        virtual void parseLine(const std::string& line) = 0;
+        //Parser specific result of classifying a run of consecutive lines
+        class Chunk {
+            public:
+            virtual ~Chunk() = default;
+        };
+
+        //'line' is only valid for the duration of the call
+        virtual void parseLine(std::string_view line) = 0;
+
+        //Parallel parsing: lines of a chunk are classified on any thread,
+        //chunks are then committed one by one in input order. Lines passed to
+        //classifyLine() have to stay valid until their chunk is committed.
+        virtual std::unique_ptr<Chunk> createChunk() const = 0;
+        virtual void classifyLine(std::string_view line, Chunk& chunk) const = 0;
+        virtual void commitChunk(const Chunk& chunk) = 0;
     };
 }
 
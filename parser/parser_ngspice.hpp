@@ -4,8 +4,17 @@
 #include <iostream>
 #include <fstream>
 #include <algorithm>
-#include <regex>
+#include <list>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <string>
+#include <string_view>
 #include <parser_interface.hpp>
+#include <tokenizer.hpp>
+#include <library_cache.hpp>
+#include <file_utils.hpp>
+#include <logger.hpp>
 #include <circuit.hpp>
 
 namespace parsers {
@@ -16,32 +25,59 @@ namespace parsers {
             None,
             Line,
             SectionBegin,
-            SectionEnd
+            SectionEnd,
+            SubcircuitBegin,
+            SubcircuitEnd,
+            Include
         };
 
+        static const std::pair<std::string, std::string> m_subcircuitSection;
         static const std::list<std::pair<std::string, std::string>> m_ignoreSections;
         static const std::list<char> m_ignoreLines;
+        static const std::list<std::string> m_includeCommands;
 
         bool m_ignore;
         TCircuit& m_circuit;
 
-        IgnoreStatus checkIgnore(std::string token) const {
-            std::transform(token.begin(), token.end(), token.begin(), ::tolower);
+        //Netlist being parsed, followed by the files being included into it
+        std::vector<std::string> m_files;
+
+        //Definitions being parsed, innermost last
+        std::vector<std::unique_ptr<circuit::SubcircuitDefinition>> m_subcircuits;
+
+        Tokenizer m_tokenizer;
+        std::vector<std::string_view> m_connections;
+
+        static IgnoreStatus checkIgnore(std::string_view token) {
+            if(equalsNoCase(m_subcircuitSection.first, token)) {
+                return IgnoreStatus::SubcircuitBegin;
+            } else if(equalsNoCase(m_subcircuitSection.second, token)) {
+                return IgnoreStatus::SubcircuitEnd;
+            }
 
             auto itS = std::find_if(m_ignoreSections.begin(), m_ignoreSections.end(), [&](const auto& pair) {
-                    return (pair.first == token || pair.second == token) ? true : false;
+                    return (equalsNoCase(pair.first, token) || equalsNoCase(pair.second, token)) ? true : false;
                     });
 
             if(itS != m_ignoreSections.end()) {
-                if(itS->first == token) {
+                if(equalsNoCase(itS->first, token)) {
                     return IgnoreStatus::SectionBegin;
-                } else if(itS->second == token) {
+                } else if(equalsNoCase(itS->second, token)) {
                     return IgnoreStatus::SectionEnd;
                 }
             }
 
+            auto itI = std::find_if(m_includeCommands.begin(), m_includeCommands.end(), [&](const auto& cmd) {
+                    return equalsNoCase(cmd, token);
+                    });
+
+            if(itI != m_includeCommands.end()) {
+                return IgnoreStatus::Include;
+            }
+
+            const char first = ::tolower(static_cast<unsigned char>(token.at(0)));
             auto itL = std::find_if(m_ignoreLines.begin(), m_ignoreLines.end(), [&](const auto& c){
-                    return (c == token.at(0)) ? true : false;
+                    return (c == first) ? true : false;
                     });
 
             if(itL != m_ignoreLines.end()) {
@@ -51,74 +87,307 @@ namespace parsers {
             return IgnoreStatus::None;
         }
 
-        void findTokens(std::string str, std::vector<std::string>& tokens, const std::string& regex) const {
-            std::regex r(regex.c_str());
-            std::smatch sm;
-            while(regex_search(str, sm, r)) {
-                if(sm.size() > 0) { 
-                    std::string token = sm[0];
-                    token.erase(std::remove(token.begin(), token.end(), ' '), token.end());
-                    tokens.emplace_back(token);
+        void printTokens(const std::vector<std::string_view>& tokens) const {
+            for(const auto& tkn : tokens) {
+                logging::debug("Token:", tkn);
+            }
+        }
+
+        //Tokens of all component and include lines in a chunk are stored back to back in 'tokens'
+        class ParsedChunk : public Chunk {
+            public:
+            struct Line {
+                std::string_view text;
+                IgnoreStatus status;
+                std::uint32_t firstToken;
+                std::uint32_t tokensCount;
+            };
+
+            Tokenizer tokenizer;
+            std::vector<Line> lines;
+            std::vector<std::string_view> tokens;
+        };
+
+        //Serial part of line processing, the only one touching parser state.
+        //Component lines between .subckt and .ends go to the definition.
+        void applyTokens(IgnoreStatus ignoreStat, const std::string_view* tokens, std::size_t count) {
+            if(ignoreStat == IgnoreStatus::SectionBegin) {
+                m_ignore = true;
+            } else if(ignoreStat == IgnoreStatus::SectionEnd) {
+                m_ignore = false;
+            } else if(m_ignore) {
+                return;
+            } else if(ignoreStat == IgnoreStatus::SubcircuitBegin) {
+                beginSubcircuit(tokens, count);
+            } else if(ignoreStat == IgnoreStatus::SubcircuitEnd) {
+                endSubcircuit();
+            } else if(ignoreStat == IgnoreStatus::Include) {
+                //Committed through here, so inside a .subckt the included components
+                //go to the definition like its own lines
+                if(count > 1) {
+                    include(tokens[1], (count > 2) ? tokens[2] : std::string_view());
                 }
-                str = sm.suffix();
+            } else if(ignoreStat == IgnoreStatus::None && !m_subcircuits.empty()) {
+                m_subcircuits.back()->addComponent(tokens, getComponentTokensCount(tokens, count));
+            } else if(ignoreStat == IgnoreStatus::None) {
+                applyComponent(tokens, count, false);
             }
         }
 
-        void printTokens(const std::vector<std::string>& tokens) const {
-            for(const auto& tkn : tokens) {
-                std::cout << "Token:" << tkn << std::endl;
+        //Commits lines of the included file, or of its library section 'entry',
+        //in place of the include line. Files already being included are skipped,
+        //so recursive includes cannot loop.
+        void include(std::string_view path, std::string_view entry) {
+            const auto filename = file_reader::resolveIncludePath(m_files.back(), path);
+            m_circuit.addDependency(filename);
+            if(std::find(m_files.begin(), m_files.end(), filename) != m_files.end()) {
+                logging::error("Recursive include of '", filename, "' ignored");
+                return;
+            }
+            if(!file_reader::getFileStamp(filename).exists) {
+                logging::error("Included file '", filename, "' not found");
+                return;
             }
+
+            const auto library = LibraryCache<ParserNGSPICE>::instance().get(filename, *this);
+            const auto* section = library->getSection(entry);
+            if(section == nullptr) {
+                logging::error("Library section '", entry, "' not found in '", filename, "'");
+                return;
+            }
+
+            const auto ignore = m_ignore;
+            m_ignore = false;
+            m_files.emplace_back(filename);
+            commitChunk(*section);
+            m_files.pop_back();
+            m_ignore = ignore;
         }
 
-        void parseTokens(const std::vector<std::string>& tokens) {
+        //.subckt <name> <ports...> [params: <name>=<value>...]
+        void beginSubcircuit(const std::string_view* tokens, std::size_t count) {
+            if(count < 2) {
+                logging::error("Subcircuit without a name ignored");
+                return;
+            }
+
+            std::vector<std::string_view> ports;
+            for(std::size_t idx = 2; idx < count && !isParameter(tokens[idx]); ++idx) {
+                ports.emplace_back(tokens[idx]);
+            }
+            m_subcircuits.emplace_back(std::make_unique<circuit::SubcircuitDefinition>(tokens[1], ports));
+        }
+
+        //Nested definitions are made global, as if defined outside of their parent
+        void endSubcircuit() {
+            if(m_subcircuits.empty()) {
+                return;
+            }
+
+            std::shared_ptr<const circuit::SubcircuitDefinition> def(std::move(m_subcircuits.back()));
+            m_subcircuits.pop_back();
+            m_circuit.addSubcircuit(std::move(def));
+        }
+
+        static bool isParameter(std::string_view token) {
+            return token.find('=') != std::string_view::npos || equalsNoCase(token, "params:");
+        }
+
+        //Instance parameters following the subcircuit name of an X line are dropped,
+        //so the last token left names the subcircuit
+        static std::size_t getComponentTokensCount(const std::string_view* tokens, std::size_t count) {
+            if(::tolower(static_cast<unsigned char>(tokens[0].front())) == 'x') {
+                while(count > 2 && isParameter(tokens[count - 1])) {
+                    --count;
+                }
+            }
+            return count;
+        }
+
+        void applyComponent(const std::string_view* tokens, std::size_t count, bool replace) {
+            count = getComponentTokensCount(tokens, count);
+            const auto& tkn = tokens[0];
+            m_connections.assign(tokens + 1, tokens + std::max<std::size_t>(count, 2) - 1);
+            if(replace) {
+                m_circuit.updateComponent(tkn.substr(0, 1), tkn, tokens[count - 1], m_connections);
+            } else {
+                m_circuit.addComponent(tkn.substr(0, 1), tkn, tokens[count - 1], m_connections);
+            }
+        }
+
+        template<typename TFun>
+        static void forEachLine(std::string_view text, TFun&& fun) {
+            while(!text.empty()) {
+                auto end = std::min(text.find('\n'), text.size());
+                auto line = text.substr(0, end);
+                if(!line.empty() && line.back() == 0x0D) {
+                    line.remove_suffix(1);
+                }
+                fun(line);
+                text.remove_prefix(std::min(end + 1, text.size()));
+            }
+        }
+
+        void parseTokens(const std::vector<std::string_view>& tokens) {
             try {
-                const auto& tkn = tokens.at(0);
-                auto ignoreStat = checkIgnore(tkn);
-
-                if(ignoreStat == IgnoreStatus::SectionBegin) {
-                    m_ignore = true;
-                } else if(ignoreStat == IgnoreStatus::SectionEnd) {
-                    m_ignore = false;
-                } else if(!m_ignore && ignoreStat == IgnoreStatus::None) {
-                    std::list<std::string> connections;
-                    for(std::size_t i = 1; i < tokens.size() - 1; ++i) {
-                        connections.emplace_back(tokens.at(i));
-                    }
+                auto ignoreStat = checkIgnore(tokens.at(0));
+                applyTokens(ignoreStat, tokens.data(), tokens.size());
+            } catch(const std::out_of_range& e) {
+            }
+        }
 
-                    m_circuit.addComponent(std::string(1, tkn.at(0)), tkn, tokens.at(tokens.size() - 1), connections);
+        void commitLine(const typename ParsedChunk::Line& line, const ParsedChunk& chunk) {
+            try {
+                logging::debug("Line:", line.text);
+
+                if(line.status != IgnoreStatus::Line) {
+                    applyTokens(line.status, chunk.tokens.data() + line.firstToken, line.tokensCount);
                 }
             } catch(const std::out_of_range& e) {
+                throw std::runtime_error(std::string("Line processing error! '") +
+                        e.what() + std::string("'"));
             }
         }
 
         public:
-        ParserNGSPICE(TCircuit& circuit)
+        //Includes are resolved relative to 'filename', or to the working directory without one
+        ParserNGSPICE(TCircuit& circuit, const std::string& filename = std::string())
             : m_ignore(false), m_circuit(circuit) {
+            m_files.emplace_back((filename.empty() || filename == "-") ? std::string() : file_reader::getAbsolutePath(filename));
         }
 
         virtual ~ParserNGSPICE() = default;
 
-        virtual void parseLine(const std::string& line) override {
+        virtual void parseLine(std::string_view line) override {
             try {
-                std::cout << "Line:" << line << std::endl;
+                logging::debug("Line:", line);
 
-                std::vector<std::string> tokens;
-                findTokens(line, tokens, "\\s*\\S+");
-                parseTokens(tokens);
+                parseTokens(m_tokenizer.tokenize(line));
             } catch(const std::out_of_range& e) {
                 throw std::runtime_error(std::string("Line processing error! '") +
                         e.what() + std::string("'"));
             }
         }
 
+        //Incremental updates: kind of a line as far as parser state is concerned
+        enum class LineKind {
+            Other,
+            SectionBegin,
+            SectionEnd,
+            Include
+        };
+
+        static LineKind getLineKind(std::string_view line) {
+            const auto first = line.find_first_not_of(" \t");
+            if(first == std::string_view::npos || line[first] != '.') {
+                return LineKind::Other;
+            }
+
+            Tokenizer tokenizer;
+            const auto& tokens = tokenizer.tokenize(line);
+            switch(tokens.empty() ? IgnoreStatus::Line : checkIgnore(tokens.front())) {
+                case IgnoreStatus::SectionBegin:
+                case IgnoreStatus::SubcircuitBegin:
+                    return LineKind::SectionBegin;
+                case IgnoreStatus::SectionEnd:
+                case IgnoreStatus::SubcircuitEnd:
+                    return LineKind::SectionEnd;
+                case IgnoreStatus::Include:
+                    return LineKind::Include;
+                default:
+                    return LineKind::Other;
+            }
+        }
+
+        //Applies replacement of the lines in 'oldText' by the lines in 'newText'.
+        //Neither may contain lines other than LineKind::Other, both have to be
+        //outside of ignored sections. Components keep their place when their
+        //line is edited, components of removed lines are removed. Returns false,
+        //without modifying the circuit, when names defined more than once are
+        //involved, as the outcome then depends on lines outside of the texts.
+        bool replaceLines(std::string_view oldText, std::string_view newText) {
+            std::vector<std::string_view> removed;
+            std::vector<std::string_view> added;
+            auto collectNames = [&](std::string_view text, std::vector<std::string_view>& names) {
+                forEachLine(text, [&](std::string_view line) {
+                        const auto& tokens = m_tokenizer.tokenize(line);
+                        if(!tokens.empty() && checkIgnore(tokens.front()) == IgnoreStatus::None) {
+                            names.emplace_back(tokens.front());
+                        }
+                        });
+                std::sort(names.begin(), names.end());
+                return std::adjacent_find(names.begin(), names.end()) == names.end();
+            };
+
+            if(!collectNames(oldText, removed) || !collectNames(newText, added)) {
+                return false;
+            }
+            for(const auto& name : removed) {
+                if(m_circuit.isDuplicated(name)) {
+                    return false;
+                }
+            }
+            for(const auto& name : added) {
+                if(m_circuit.hasComponent(name) && !std::binary_search(removed.begin(), removed.end(), name)) {
+                    return false;
+                }
+            }
+
+            forEachLine(newText, [&](std::string_view line) {
+                    logging::debug("Line:", line);
+                    const auto& tokens = m_tokenizer.tokenize(line);
+                    if(!tokens.empty() && checkIgnore(tokens.front()) == IgnoreStatus::None) {
+                        applyComponent(tokens.data(), tokens.size(), true);
+                    }
+                    });
+
+            for(const auto& name : removed) {
+                if(!std::binary_search(added.begin(), added.end(), name)) {
+                    m_circuit.removeComponent(name);
+                }
+            }
+            return true;
+        }
+
+        virtual std::unique_ptr<Chunk> createChunk() const override {
+            return std::make_unique<ParsedChunk>();
+        }
+
+        //Thread safe, only the chunk is modified
+        virtual void classifyLine(std::string_view line, Chunk& chunk) const override {
+            auto& parsed = static_cast<ParsedChunk&>(chunk);
+            const auto& tokens = parsed.tokenizer.tokenize(line);
+
+            const auto ignoreStat = tokens.empty() ? IgnoreStatus::Line : checkIgnore(tokens.front());
+            const auto firstToken = static_cast<std::uint32_t>(parsed.tokens.size());
+            if(ignoreStat == IgnoreStatus::None || ignoreStat == IgnoreStatus::Include || ignoreStat == IgnoreStatus::SubcircuitBegin) {
+                parsed.tokens.insert(parsed.tokens.end(), tokens.begin(), tokens.end());
+            }
+
+            const auto count = static_cast<std::uint32_t>(parsed.tokens.size()) - firstToken;
+            parsed.lines.push_back({ line, ignoreStat, firstToken, count });
+        }
+
+        virtual void commitChunk(const Chunk& chunk) override {
+            const auto& parsed = static_cast<const ParsedChunk&>(chunk);
+            for(const auto& line : parsed.lines) {
+                commitLine(line, parsed);
+            }
+        }
+
     };
 
     template<typename TCircuit>
-    const std::list<std::pair<std::string, std::string>> ParserNGSPICE<TCircuit>::m_ignoreSections = { {".control", ".endc"},
-                                                                                                       {".subckt", ".ends"} };
+    const std::pair<std::string, std::string> ParserNGSPICE<TCircuit>::m_subcircuitSection = { ".subckt", ".ends" };
+
+    template<typename TCircuit>
+    const std::list<std::pair<std::string, std::string>> ParserNGSPICE<TCircuit>::m_ignoreSections = { {".control", ".endc"} };
 
     template<typename TCircuit>
     const std::list<char> ParserNGSPICE<TCircuit>::m_ignoreLines = { '*', '.', 'v', 'i' };
+
+    template<typename TCircuit>
+    const std::list<std::string> ParserNGSPICE<TCircuit>::m_includeCommands = { ".include", ".inc", ".lib" };
 }
 
 #endif
@@ -0,0 +1,65 @@
+#ifndef TOKENIZER
+#define TOKENIZER
+
+#include <string_view>
+#include <vector>
+#include <cctype>
+
+namespace parsers {
+
+    inline bool equalsNoCase(std::string_view a, std::string_view b) {
+        if(a.size() != b.size()) {
+            return false;
+        }
+        for(std::size_t i = 0; i < a.size(); ++i) {
+            if(::tolower(static_cast<unsigned char>(a[i])) != ::tolower(static_cast<unsigned char>(b[i]))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    //Single pass whitespace tokenizer. Tokens are views into the tokenized
+    //line and the token buffer is reused between calls, so in steady state
+    //tokenizing a line does not allocate.
+    class Tokenizer {
+        std::vector<std::string_view> m_tokens;
+
+        static bool isSpace(char c) {
+            return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+        }
+
+        public:
+        Tokenizer() {
+            m_tokens.reserve(16);
+        }
+
+        virtual ~Tokenizer() = default;
+
+        //Returned tokens are valid until the next call and as long as 'line' is alive
+        const std::vector<std::string_view>& tokenize(std::string_view line) {
+            m_tokens.clear();
+
+            const char* const data = line.data();
+            const std::size_t size = line.size();
+            std::size_t pos = 0;
+            while(pos < size) {
+                while(pos < size && isSpace(data[pos])) {
+                    ++pos;
+                }
+
+                const std::size_t begin = pos;
+                while(pos < size && !isSpace(data[pos])) {
+                    ++pos;
+                }
+
+                if(pos > begin) {
+                    m_tokens.emplace_back(data + begin, pos - begin);
+                }
+            }
+            return m_tokens;
+        }
+    };
+}
+
+#endif
@@ -10,7 +10,7 @@ QMAKE_PROJECT_NAME = spice_visualizer
 LOGMODE = -D_VERBOSE
 
 INCLUDEPATH += .
-INCLUDEPATH += ./file_io ./parser ./circuit ./task ./gui ./gui_qt
+INCLUDEPATH += ./file_io ./parser ./circuit ./task ./gui ./gui_qt ./logging
 QMAKE_CXXFLAGS += -Wextra -pedantic -std=c++17 $$LOGMODE
 
 # Input
@@ -18,17 +18,43 @@ HEADERS += gui_qt/schematic.h \
 gui_qt/schematic_params.hpp \
 gui_qt/schematic_component_base.hpp \
 gui_qt/schematic_component.hpp \
+gui_qt/label_font.hpp \
+gui_qt/schematic_wire.hpp \
+gui_qt/schematic_overview.hpp \
+gui_qt/wire_router.hpp \
 gui_qt/progress.h \
 gui/gui_schematic_interface.hpp \
 gui/gui_schematic_qt.hpp \
+gui/gui_schematic_null.hpp \
 gui/gui_progress_interface.hpp \
 gui/gui_progress_qt.hpp \
+gui/gui_progress_phase.hpp \
+gui/gui_progress_console.hpp \
 circuit/circuit.hpp \
+circuit/symbol_table.hpp \
+circuit/subcircuit.hpp \
+circuit/graph_view.hpp \
+circuit/scratch_array.hpp \
 circuit/processor.hpp \
+circuit/pipeline.hpp \
+circuit/batch_processor.hpp \
+circuit/circuit_export.hpp \
+circuit/circuit_cache.hpp \
+circuit/netlist_updater.hpp \
+circuit/placement.hpp \
 task/base_thread.hpp \
+task/thread_pool.hpp \
+logging/logger.hpp \
 file_io/file_reader.hpp \
+file_io/mapped_file.hpp \
+file_io/file_utils.hpp \
+file_io/file_watcher.hpp \
 parser/parser_ngspice.hpp \
-parser/parser_interface.hpp
+parser/netlist_library.hpp \
+parser/library_cache.hpp \
+parser/tokenizer.hpp \
+parser/parser_interface.hpp \
+version.hpp
 
 SOURCES += main.cpp \
 gui_qt/schematic.cpp \
@@ -4,6 +4,8 @@
 #include <thread>
 #include <atomic>
 #include <chrono>
+#include <mutex>
+#include <condition_variable>
 
 namespace task {
 
@@ -12,12 +14,18 @@ namespace task {
         public:
         virtual void start(TArgs... args) = 0;
         virtual void stop() = 0;
+
+        //Ends the current or next msWait() of the thread
+        virtual void wake() = 0;
     };
 
     class ThreadUserInterface {
         public:
         virtual bool isRunning() const = 0;
         virtual void msSleep(std::intmax_t ms) const = 0;
+
+        //Sleeps until wake() or stop() is called, at most 'ms' unless it is negative
+        virtual void msWait(std::intmax_t ms) const = 0;
     };
 
     template<class... TArgs>
@@ -26,6 +34,10 @@ namespace task {
         std::atomic<bool> m_run;
         std::thread m_th;
 
+        mutable std::mutex m_wakeMutex;
+        mutable std::condition_variable m_wakeCv;
+        mutable bool m_woken;
+
         void join() {
             if(m_th.joinable()) {
                 m_th.join();
@@ -36,7 +48,8 @@ namespace task {
         virtual void run(TArgs... args) = 0;
 
         public:
-        BaseThread() {
+        BaseThread()
+            : m_woken(false) {
             m_run.store(false);
         }
 
@@ -63,9 +76,18 @@ namespace task {
 
         void stop() override {
             m_run.store(false);
+            wake();
             join();
         }
 
+        void wake() override {
+            {
+                std::lock_guard<std::mutex> lock(m_wakeMutex);
+                m_woken = true;
+            }
+            m_wakeCv.notify_all();
+        }
+
         bool isRunning() const override {
             return m_run.load();
         }
@@ -74,6 +96,17 @@ namespace task {
             std::this_thread::sleep_for(std::chrono::milliseconds(ms));
         }
 
+        void msWait(std::intmax_t ms) const override {
+            std::unique_lock<std::mutex> lock(m_wakeMutex);
+            auto isWoken = [&]() { return m_woken || !m_run.load(); };
+            if(ms < 0) {
+                m_wakeCv.wait(lock, isWoken);
+            } else {
+                m_wakeCv.wait_for(lock, std::chrono::milliseconds(ms), isWoken);
+            }
+            m_woken = false;
+        }
+
     };
 
 }
@@ -0,0 +1,100 @@
+#ifndef THREAD_POOL
+#define THREAD_POOL
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <functional>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <algorithm>
+
+namespace task {
+
+    //Fixed size pool of worker threads executing queued tasks in FIFO order
+    class ThreadPool {
+        std::vector<std::thread> m_workers;
+        std::deque<std::function<void()>> m_tasks;
+        std::mutex m_mtx;
+        std::condition_variable m_cv;
+        bool m_stop;
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        static bool& getWorkerFlag() {
+            thread_local bool isWorker = false;
+            return isWorker;
+        }
+
+        void work() {
+            getWorkerFlag() = true;
+            while(true) {
+                std::function<void()> fun;
+                {
+                    std::unique_lock<std::mutex> lck(m_mtx);
+                    m_cv.wait(lck, [&]() { return m_stop || !m_tasks.empty(); });
+                    if(m_tasks.empty()) {
+                        return;
+                    }
+                    fun = std::move(m_tasks.front());
+                    m_tasks.pop_front();
+                }
+                fun();
+            }
+        }
+
+        public:
+        ThreadPool(std::size_t threads = getDefaultSize())
+            : m_stop(false) {
+            threads = std::max<std::size_t>(threads, 1);
+            for(std::size_t i = 0; i < threads; ++i) {
+                m_workers.emplace_back([this]() { work(); });
+            }
+        }
+
+        //Pending tasks are still executed before the workers exit
+        virtual ~ThreadPool() {
+            {
+                std::unique_lock<std::mutex> lck(m_mtx);
+                m_stop = true;
+            }
+            m_cv.notify_all();
+            for(auto& th : m_workers) {
+                th.join();
+            }
+        }
+
+        static std::size_t getDefaultSize() {
+            return std::max<unsigned>(std::thread::hardware_concurrency(), 1);
+        }
+
+        //True on the workers of any pool. Their tasks already keep all cores
+        //busy, pools started by them would only oversubscribe the machine.
+        static bool isWorkerThread() {
+            return getWorkerFlag();
+        }
+
+        std::size_t size() const {
+            return m_workers.size();
+        }
+
+        //Exceptions thrown by 'fun' are rethrown from the returned future
+        template<typename TFun>
+        auto submit(TFun&& fun) -> std::future<decltype(fun())> {
+            typedef decltype(fun()) TResult;
+            auto task = std::make_shared<std::packaged_task<TResult()>>(std::forward<TFun>(fun));
+            auto result = task->get_future();
+            {
+                std::unique_lock<std::mutex> lck(m_mtx);
+                m_tasks.emplace_back([task]() { (*task)(); });
+            }
+            m_cv.notify_one();
+            return result;
+        }
+    };
+}
+
+#endif
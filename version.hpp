@@ -0,0 +1,9 @@
+#ifndef VERSION
+#define VERSION
+
+namespace app {
+
+    constexpr const char* g_version = "1.0";
+}
+
+#endif